@@ -0,0 +1,64 @@
+#include "line_framer.h"
+#include <algorithm>
+
+LineFramer::LineFramer(size_t capacity)
+    : buffer_(capacity > 0 ? capacity : 1)
+    , head_(0)
+    , scan_(0)
+    , tail_(0)
+    , discarding_(false)
+    , dropped_(0) {
+}
+
+char* LineFramer::writePtr() {
+    return buffer_.data() + tail_ % buffer_.size();
+}
+
+size_t LineFramer::writable() const {
+    size_t free = buffer_.size() - buffered();
+    size_t to_end = buffer_.size() - static_cast<size_t>(tail_ % buffer_.size());
+    return std::min(free, to_end);
+}
+
+void LineFramer::commit(size_t count) {
+    tail_ += std::min(count, writable());
+}
+
+bool LineFramer::nextLine(std::string& line) {
+    const size_t capacity = buffer_.size();
+
+    while (scan_ < tail_) {
+        if (buffer_[scan_ % capacity] != '\n') {
+            ++scan_;
+            continue;
+        }
+
+        uint64_t end = scan_;
+        uint64_t start = head_;
+        head_ = scan_ = end + 1;
+        if (discarding_) {
+            discarding_ = false;
+            continue;
+        }
+
+        line.clear();
+        size_t length = static_cast<size_t>(end - start);
+        size_t first = std::min(length, capacity - static_cast<size_t>(start % capacity));
+        line.append(buffer_.data() + start % capacity, first);
+        line.append(buffer_.data(), length - first);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        return true;
+    }
+
+    // Full without a newline: this line can never fit, so skip to its end.
+    if (buffered() == capacity) {
+        head_ = tail_;
+        if (!discarding_) {
+            discarding_ = true;
+            ++dropped_;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,66 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "temp_log.h"
+
+int main(int argc, char* argv[]) {
+    if (argc != 4 && argc != 6) {
+        std::cout << "Usage: " << argv[0] << " <text|binary> <input> <output> [<start> <end>]" << std::endl;
+        std::cout << "Converts a temperature log to the given format. The input format is detected." << std::endl;
+        std::cout << "With <start> and <end> (Unix timestamps) only that range is copied." << std::endl;
+        std::cout << "Example: " << argv[0] << " binary logs/hourly_temp.log logs/hourly_temp.bin" << std::endl;
+        return 1;
+    }
+
+    std::string target = argv[1];
+    if (target != "text" && target != "binary") {
+        std::cerr << "Unknown format: " << target << std::endl;
+        return 1;
+    }
+    LogFormat output_format = target == "binary" ? LogFormat::Binary : LogFormat::Text;
+
+    fs::path input = argv[2];
+    fs::path output = argv[3];
+    if (!fs::exists(input)) {
+        std::cerr << "Input file not found: " << input << std::endl;
+        return 1;
+    }
+
+    try {
+        std::vector<TempReading> readings;
+        bool ranged = argc == 6;
+        time_t start = ranged ? static_cast<time_t>(std::stoll(argv[4])) : 0;
+        time_t end = ranged ? static_cast<time_t>(std::stoll(argv[5])) : 0;
+
+        if (detectLogFormat(input) == LogFormat::Binary) {
+            MappedTempLog log;
+            if (!log.open(input)) {
+                std::cerr << "Failed to map binary log: " << input << std::endl;
+                return 1;
+            }
+
+            const BinaryLogRecord* first = ranged ? log.lowerBound(start) : log.begin();
+            const BinaryLogRecord* last = ranged ? log.upperBound(end) : log.end();
+            for (const BinaryLogRecord* it = first; it < last; ++it) {
+                readings.push_back({static_cast<time_t>(it->timestamp), it->temperature});
+            }
+        } else {
+            for (const auto& reading : readTempLog(input, LogFormat::Text)) {
+                if (!ranged || (reading.timestamp >= start && reading.timestamp <= end)) {
+                    readings.push_back(reading);
+                }
+            }
+        }
+
+        if (!writeTempLog(output, output_format, readings)) {
+            std::cerr << "Failed to write " << output << std::endl;
+            return 1;
+        }
+
+        std::cout << "Converted " << readings.size() << " records to " << output << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef _WIN32
+
+#include "temp_log.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+bool MappedTempLog::map(const fs::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+
+    void* data = mmap(nullptr, length_, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    data_ = data;
+    return true;
+}
+
+void MappedTempLog::unmap() {
+    munmap(data_, length_);
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifdef _WIN32
+
+#include "temp_log.h"
+#include <windows.h>
+
+bool MappedTempLog::map(const fs::path& path) {
+    HANDLE file = CreateFileW(path.c_str(),
+                              GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) {
+        return false;
+    }
+
+    // The view keeps the mapping object alive after its handle is closed.
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, length_);
+    CloseHandle(mapping);
+
+    if (!data) {
+        return false;
+    }
+
+    data_ = data;
+    return true;
+}
+
+void MappedTempLog::unmap() {
+    UnmapViewOfFile(data_);
+}
+
+#endif
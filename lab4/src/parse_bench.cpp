@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "reading_parser.h"
+
+// Compares the ways of parsing sensor lines: one std::istringstream per
+// line (what the monitors used to do), parseReading per line, and
+// parseReadings over one buffer holding all the lines.
+
+namespace {
+
+struct Result {
+    size_t parsed = 0;
+    double checksum = 0;
+};
+
+double bestSeconds(int rounds, const std::function<Result()>& run, Result& result) {
+    double best = 1e9;
+    for (int i = 0; i < rounds; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        result = run();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+void report(const char* name, double seconds, size_t lines, size_t bytes, const Result& result) {
+    std::cout << name << ": " << seconds * 1e9 / lines << " ns/line, "
+              << bytes / seconds / 1e6 << " MB/s (" << result.parsed << " parsed, checksum "
+              << result.checksum << ")" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? static_cast<size_t>(std::atol(argv[1])) : 1000000;
+    int rounds = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+
+    // Lines as temp_sensor writes them in text mode.
+    std::mt19937 gen(42);
+    std::normal_distribution<> temp_dist(20.0, 10.0);
+    std::vector<std::string> lines;
+    std::string buffer;
+    time_t timestamp = 1700000000;
+    for (size_t i = 0; i < count; ++i) {
+        std::ostringstream oss;
+        oss << timestamp++ << " " << temp_dist(gen);
+        lines.push_back(oss.str());
+        buffer += lines.back();
+        buffer += '\n';
+    }
+    std::cout << count << " lines, " << buffer.size() << " bytes, best of " << rounds << " rounds" << std::endl;
+
+    Result result;
+    double seconds = bestSeconds(rounds, [&]() {
+        Result r;
+        for (const auto& line : lines) {
+            std::istringstream iss(line);
+            time_t ts;
+            double temperature;
+            if (iss >> ts >> temperature) {
+                ++r.parsed;
+                r.checksum += temperature;
+            }
+        }
+        return r;
+    }, result);
+    report("istringstream ", seconds, count, buffer.size(), result);
+
+    seconds = bestSeconds(rounds, [&]() {
+        Result r;
+        for (const auto& line : lines) {
+            time_t ts;
+            double temperature;
+            if (parseReading(line, ts, temperature) == ParseStatus::Ok) {
+                ++r.parsed;
+                r.checksum += temperature;
+            }
+        }
+        return r;
+    }, result);
+    report("parseReading  ", seconds, count, buffer.size(), result);
+
+    seconds = bestSeconds(rounds, [&]() {
+        Result r;
+        ParseStats stats;
+        parseReadings(buffer, stats, [&r](time_t, double temperature, size_t) {
+            r.checksum += temperature;
+        });
+        r.parsed = static_cast<size_t>(stats.parsed);
+        return r;
+    }, result);
+    report("parseReadings ", seconds, count, buffer.size(), result);
+    return 0;
+}
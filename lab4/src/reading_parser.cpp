@@ -0,0 +1,84 @@
+#include "reading_parser.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+const char* skipBlanks(const char* first, const char* last) {
+    while (first != last && isBlank(*first)) {
+        ++first;
+    }
+    return first;
+}
+
+// Returns the end of the number, or nullptr if there is none.
+const char* parseDouble(const char* first, const char* last, double& value) {
+#if defined(__cpp_lib_to_chars)
+    auto result = std::from_chars(first, last, value);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+#else
+    // Standard libraries without floating point from_chars (older libc++)
+    // get strtod on a terminated copy; it follows the C locale only as long
+    // as nobody calls setlocale().
+    char copy[64];
+    size_t length = std::min(static_cast<size_t>(last - first), sizeof(copy) - 1);
+    std::copy(first, first + length, copy);
+    copy[length] = '\0';
+
+    char* end = nullptr;
+    value = std::strtod(copy, &end);
+    if (end == copy || std::isspace(static_cast<unsigned char>(copy[0])) || copy[0] == '+') {
+        return nullptr;
+    }
+    return first + (end - copy);
+#endif
+}
+
+} // namespace
+
+const char* parseStatusName(ParseStatus status) {
+    switch (status) {
+        case ParseStatus::Ok: return "ok";
+        case ParseStatus::Empty: return "empty line";
+        case ParseStatus::BadTimestamp: return "bad timestamp";
+        case ParseStatus::BadTemperature: return "bad temperature";
+        case ParseStatus::TrailingData: return "trailing data";
+    }
+    return "unknown";
+}
+
+ParseStatus parseReading(std::string_view line, time_t& timestamp, double& temperature) {
+    const char* p = skipBlanks(line.data(), line.data() + line.size());
+    const char* last = line.data() + line.size();
+    if (p == last) {
+        return ParseStatus::Empty;
+    }
+
+    time_t ts;
+    auto result = std::from_chars(p, last, ts);
+    if (result.ec != std::errc() || (result.ptr != last && !isBlank(*result.ptr))) {
+        return ParseStatus::BadTimestamp;
+    }
+
+    p = skipBlanks(result.ptr, last);
+    double value;
+    const char* end = p == last ? nullptr : parseDouble(p, last, value);
+    if (!end || !std::isfinite(value)) {
+        return ParseStatus::BadTemperature;
+    }
+
+    if (skipBlanks(end, last) != last) {
+        return ParseStatus::TrailingData;
+    }
+
+    timestamp = ts;
+    temperature = value;
+    return ParseStatus::Ok;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string_view>
+
+// Parser for "<timestamp> <temperature>" records, as sent by the sensor in
+// text mode and stored in text logs. Built on std::from_chars: it does not
+// allocate, ignores the locale and reports bad input by status, not by
+// exception.
+enum class ParseStatus {
+    Ok,
+    Empty,           // blank line
+    BadTimestamp,    // missing, not an integer or out of range
+    BadTemperature,  // missing, not a number, out of range or not finite
+    TrailingData     // anything but whitespace after the temperature
+};
+
+const char* parseStatusName(ParseStatus status);
+
+// Parses one line, without its "\n"; surrounding spaces, tabs and a
+// trailing "\r" are allowed. timestamp and temperature are only written
+// when the result is Ok.
+ParseStatus parseReading(std::string_view line, time_t& timestamp, double& temperature);
+
+struct ParseStats {
+    uint64_t parsed = 0;
+    uint64_t malformed = 0;  // blank lines are skipped without counting
+};
+
+// Parses every complete line of buffer and calls
+// onReading(timestamp, temperature, offset) for each valid one, offset
+// being where its line starts in buffer. Returns the number of bytes up to
+// and including the last "\n"; a trailing partial line is left to the caller.
+template <typename OnReading>
+size_t parseReadings(std::string_view buffer, ParseStats& stats, OnReading&& onReading) {
+    size_t start = 0;
+    for (;;) {
+        size_t end = buffer.find('\n', start);
+        if (end == std::string_view::npos) {
+            return start;
+        }
+
+        time_t timestamp;
+        double temperature;
+        ParseStatus status = parseReading(buffer.substr(start, end - start), timestamp, temperature);
+        if (status == ParseStatus::Ok) {
+            ++stats.parsed;
+            onReading(timestamp, temperature, start);
+        } else if (status != ParseStatus::Empty) {
+            ++stats.malformed;
+        }
+        start = end + 1;
+    }
+}
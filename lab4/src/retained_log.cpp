@@ -0,0 +1,75 @@
+#include "retained_log.h"
+#include <iostream>
+#include <stdexcept>
+
+RetainedLog::RetainedLog(const fs::path& path, LogFormat format,
+                         time_t retention, time_t compact_after)
+    : path_(path)
+    , format_(format)
+    , retention_(retention)
+    , compact_after_(compact_after)
+    , writer_(TempLogWriter::create(format)) {
+    loadIndex();
+    if (!writer_->open(path_)) {
+        throw std::runtime_error("Failed to open log: " + path_.string());
+    }
+}
+
+RetainedLog::~RetainedLog() {
+    close();
+}
+
+void RetainedLog::loadIndex() {
+    if (!fs::exists(path_)) {
+        return;
+    }
+
+    forEachTempRecord(path_, format_, [this](const TempReading& reading, uint64_t offset) {
+        index_.push_back({reading.timestamp, offset});
+    });
+}
+
+void RetainedLog::append(const TempReading& reading) {
+    uint64_t offset = writer_->dataSize();
+    if (!writer_->append(reading)) {
+        std::cerr << "Failed to write to " << path_ << std::endl;
+        return;
+    }
+    index_.push_back({reading.timestamp, offset});
+}
+
+void RetainedLog::enforceRetention(time_t now) {
+    time_t cutoff = now - retention_;
+    if (index_.empty() || index_.front().timestamp >= cutoff - compact_after_) {
+        return;
+    }
+    compact(cutoff);
+}
+
+void RetainedLog::compact(time_t cutoff) {
+    size_t expired = 0;
+    while (expired < index_.size() && index_[expired].timestamp < cutoff) {
+        ++expired;
+    }
+
+    uint64_t keep_from = expired < index_.size() ? index_[expired].offset : writer_->dataSize();
+
+    writer_->close();
+    bool dropped = dropTempLogHead(path_, format_, keep_from);
+    if (!writer_->open(path_)) {
+        throw std::runtime_error("Failed to reopen log: " + path_.string());
+    }
+    if (!dropped) {
+        std::cerr << "Failed to compact " << path_ << std::endl;
+        return;
+    }
+
+    index_.erase(index_.begin(), index_.begin() + expired);
+    for (auto& entry : index_) {
+        entry.offset -= keep_from;
+    }
+}
+
+void RetainedLog::close() {
+    writer_->close();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include "temp_log.h"
+#include "temp_reading.h"
+
+namespace fs = std::filesystem;
+
+// Single-file log with a sliding retention window.
+// Keeps an in-memory index of (timestamp, data offset) for every record, so
+// checking retention is O(1). The file is only rewritten once its oldest
+// record is older than retention + compact_after, and then the expired head
+// is cut off in one pass.
+class RetainedLog {
+public:
+    RetainedLog(const fs::path& path, LogFormat format,
+                time_t retention, time_t compact_after);
+    ~RetainedLog();
+
+    void append(const TempReading& reading);
+    void enforceRetention(time_t now);
+    void close();
+
+private:
+    struct IndexEntry {
+        time_t timestamp;
+        uint64_t offset;
+    };
+
+    void loadIndex();
+    void compact(time_t cutoff);
+
+    fs::path path_;
+    LogFormat format_;
+    time_t retention_;
+    time_t compact_after_;
+
+    std::unique_ptr<TempLogWriter> writer_;
+    std::deque<IndexEntry> index_;
+};
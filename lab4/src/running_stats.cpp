@@ -0,0 +1,61 @@
+#include "running_stats.h"
+#include <algorithm>
+#include <cmath>
+
+RunningStats::RunningStats() {
+    reset();
+}
+
+void RunningStats::add(double value) {
+    if (count_ == 0) {
+        min_ = value;
+        max_ = value;
+    } else {
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    ++count_;
+    sum_ += value;
+
+    double delta = value - mean_;
+    mean_ += delta / count_;
+    m2_ += delta * (value - mean_);
+}
+
+void RunningStats::merge(const RunningStats& other) {
+    if (other.count_ == 0) {
+        return;
+    }
+    if (count_ == 0) {
+        *this = other;
+        return;
+    }
+
+    uint64_t total = count_ + other.count_;
+    double delta = other.mean_ - mean_;
+
+    mean_ += delta * other.count_ / total;
+    m2_ += other.m2_ + delta * delta * (static_cast<double>(count_) * other.count_ / total);
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    count_ = total;
+}
+
+void RunningStats::reset() {
+    count_ = 0;
+    sum_ = 0.0;
+    min_ = 0.0;
+    max_ = 0.0;
+    mean_ = 0.0;
+    m2_ = 0.0;
+}
+
+double RunningStats::variance() const {
+    return count_ > 0 ? m2_ / count_ : 0.0;
+}
+
+double RunningStats::stddev() const {
+    return std::sqrt(variance());
+}
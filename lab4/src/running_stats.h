@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+// Constant-size streaming summary of a series of values.
+// Mean and variance use Welford's update, and merge() combines two
+// summaries (Chan et al.), so closing a bucket or rolling it into a
+// coarser one costs O(1) regardless of how many values it saw.
+class RunningStats {
+public:
+    RunningStats();
+
+    void add(double value);
+    void merge(const RunningStats& other);
+    void reset();
+
+    uint64_t count() const { return count_; }
+    double sum() const { return sum_; }
+    double min() const { return min_; }
+    double max() const { return max_; }
+    double mean() const { return mean_; }
+    // Population variance of the values seen so far.
+    double variance() const;
+    double stddev() const;
+
+private:
+    uint64_t count_;
+    double sum_;
+    double min_;
+    double max_;
+    double mean_;
+    double m2_;
+};
@@ -0,0 +1,99 @@
+#include "segmented_log.h"
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+#include <stdexcept>
+
+SegmentedLog::SegmentedLog(const fs::path& dir, const std::string& prefix,
+                           time_t segment_span, time_t retention,
+                           LogFormat format)
+    : dir_(dir)
+    , prefix_(prefix)
+    , segment_span_(segment_span)
+    , retention_(retention)
+    , format_(format)
+    , current_(TempLogWriter::create(format))
+    , current_start_(-1) {
+    fs::create_directories(dir_);
+    loadSegments();
+}
+
+SegmentedLog::~SegmentedLog() {
+    close();
+}
+
+fs::path SegmentedLog::segmentPath(time_t segment_start) const {
+    return dir_ / (prefix_ + "_" + std::to_string(segment_start) + logExtension(format_));
+}
+
+void SegmentedLog::loadSegments() {
+    const std::string head = prefix_ + "_";
+    for (const auto& entry : fs::directory_iterator(dir_)) {
+        if (!entry.is_regular_file() || entry.path().extension() != logExtension(format_)) {
+            continue;
+        }
+
+        std::string stem = entry.path().stem().string();
+        if (stem.size() <= head.size() || stem.compare(0, head.size(), head) != 0) {
+            continue;
+        }
+
+        std::string digits = stem.substr(head.size());
+        bool numeric = std::all_of(digits.begin(), digits.end(), [](char c) { return c >= '0' && c <= '9'; });
+        time_t segment_start;
+        auto result = std::from_chars(digits.data(), digits.data() + digits.size(), segment_start);
+        if (!numeric || result.ec != std::errc()) {
+            continue;
+        }
+        segments_.push_back(segment_start);
+    }
+    std::sort(segments_.begin(), segments_.end());
+}
+
+void SegmentedLog::openSegment(time_t segment_start) {
+    current_->close();
+    if (!current_->open(segmentPath(segment_start))) {
+        throw std::runtime_error("Failed to open log segment: " + segmentPath(segment_start).string());
+    }
+
+    current_start_ = segment_start;
+    auto it = std::lower_bound(segments_.begin(), segments_.end(), segment_start);
+    if (it == segments_.end() || *it != segment_start) {
+        segments_.insert(it, segment_start);
+    }
+}
+
+void SegmentedLog::dropExpiredSegments(time_t now) {
+    time_t cutoff = now - retention_;
+    while (!segments_.empty() && segments_.front() + segment_span_ <= cutoff) {
+        if (segments_.front() == current_start_) {
+            break;
+        }
+
+        std::error_code ec;
+        fs::remove(segmentPath(segments_.front()), ec);
+        if (ec) {
+            std::cerr << "Failed to remove log segment: " << ec.message() << std::endl;
+        }
+        segments_.pop_front();
+    }
+}
+
+void SegmentedLog::append(const TempReading& reading) {
+    time_t segment_start = reading.timestamp - reading.timestamp % segment_span_;
+
+    // Late readings stay in the open segment rather than reopening an old one.
+    if (current_start_ < 0 || segment_start > current_start_) {
+        openSegment(segment_start);
+        dropExpiredSegments(reading.timestamp);
+    }
+
+    if (!current_->append(reading)) {
+        std::cerr << "Failed to append to log segment: " << segmentPath(current_start_) << std::endl;
+    }
+}
+
+void SegmentedLog::close() {
+    current_->close();
+    current_start_ = -1;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include "temp_log.h"
+#include "temp_reading.h"
+
+namespace fs = std::filesystem;
+
+// Append-only log split into time-bucketed segment files.
+// Each segment covers [start, start + segment_span) and is named
+// "<prefix>_<start>.log" (".bin" for binary logs). Writes only ever
+// append to the newest segment; retention deletes whole segments once
+// they are older than the window, and runs only when a new segment is opened.
+class SegmentedLog {
+public:
+    SegmentedLog(const fs::path& dir, const std::string& prefix,
+                 time_t segment_span, time_t retention,
+                 LogFormat format = LogFormat::Text);
+    ~SegmentedLog();
+
+    void append(const TempReading& reading);
+    void close();
+
+private:
+    fs::path segmentPath(time_t segment_start) const;
+    void loadSegments();
+    void openSegment(time_t segment_start);
+    void dropExpiredSegments(time_t now);
+
+    fs::path dir_;
+    std::string prefix_;
+    time_t segment_span_;
+    time_t retention_;
+    LogFormat format_;
+
+    std::unique_ptr<TempLogWriter> current_;
+    time_t current_start_;
+    std::deque<time_t> segments_;
+};
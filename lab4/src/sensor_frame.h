@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+// Binary alternative to the "<timestamp> <temperature>\n" text protocol.
+// Each reading is one frame:
+//
+//   0xA5 | sensor id | varint(delta << 1 | keyframe) | int16 LE | CRC8
+//
+// The varint holds the seconds since the sensor's previous frame, or the
+// absolute timestamp when the keyframe bit is set. Temperature is in
+// hundredths of a degree. The CRC (polynomial 0x07) covers everything
+// between the sync byte and itself. A typical frame is 6 bytes.
+constexpr uint8_t FRAME_SYNC = 0xA5;
+constexpr size_t MAX_FRAME_SIZE = 1 + 1 + 10 + 2 + 1;
+
+struct SensorFrame {
+    int sensor;
+    time_t timestamp;
+    double temperature;
+};
+
+uint8_t crc8(const uint8_t* data, size_t size);
+
+// Encodes the readings of one sensor. A keyframe is sent first, every
+// keyframe_interval frames after that, and whenever the clock goes back,
+// so a receiver that starts late or lost a frame resynchronises quickly.
+class FrameEncoder {
+public:
+    explicit FrameEncoder(int sensor, unsigned keyframe_interval = 16);
+
+    // Appends the frame to out.
+    void encode(time_t timestamp, double temperature, std::string& out);
+
+private:
+    uint8_t sensor_;
+    unsigned keyframe_interval_;
+    unsigned until_keyframe_;
+    time_t last_;
+};
+
+// Ring buffer that turns a byte stream into frames, filled the same way as
+// LineFramer (writePtr/writable/commit). Bytes that do not start a valid
+// frame are skipped until the next sync byte. After such a gap the
+// previous timestamp of every sensor is forgotten, since a frame may have
+// been lost, and delta frames are dropped until that sensor's next keyframe.
+class FrameDecoder {
+public:
+    explicit FrameDecoder(size_t capacity = 4096);
+
+    char* writePtr();
+    size_t writable() const;
+    void commit(size_t count);
+
+    // Takes the next valid frame out of the buffer.
+    bool nextFrame(SensorFrame& frame);
+
+    size_t buffered() const { return static_cast<size_t>(tail_ - head_); }
+    uint64_t badFrames() const { return bad_; }
+    uint64_t unsyncedFrames() const { return unsynced_; }
+
+private:
+    uint8_t at(uint64_t position) const;
+    void resync();
+
+    std::vector<char> buffer_;
+    uint64_t head_;
+    uint64_t tail_;
+    bool in_gap_;
+    uint64_t bad_;
+    uint64_t unsynced_;
+    time_t last_[256];
+    bool has_last_[256];
+};
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "sensor_frame.h"
 #include <string>
 #include <memory>
+#include <vector>
 
 class SerialPort {
 public:
@@ -14,8 +16,32 @@ public:
     virtual bool write(const std::string& data) = 0;
     
     virtual bool read(std::string& data) = 0;
+
+    // Waits up to timeout_ms for input, then drains everything the port has
+    // and appends each complete line (without the terminator) to lines.
+    // A partial line stays buffered for the next call. Returns false only if
+    // the port is closed or the read failed; a timeout just adds no lines.
+    virtual bool readLines(std::vector<std::string>& lines, int timeout_ms) = 0;
+
+    // The same for a port carrying binary frames (sensor_frame.h): appends
+    // each complete frame to frames. A port is read either as lines or as
+    // frames, never both.
+    virtual bool readFrames(std::vector<SensorFrame>& frames, int timeout_ms) = 0;
     
     virtual bool isOpen() const = 0;
     
     static std::unique_ptr<SerialPort> create();
+
+    // readLines for many ports at once: waits up to timeout_ms until any of
+    // them has input, then drains every port that is ready. lines is resized
+    // to ports.size() and lines[i] gets the lines of ports[i] appended.
+    // A port whose read fails is closed and skipped from then on. Returns
+    // false if no port is open or waiting failed. Ports must come from create().
+    static bool readLines(const std::vector<std::unique_ptr<SerialPort>>& ports,
+                          std::vector<std::vector<std::string>>& lines, int timeout_ms);
+
+    // readFrames for many ports at once. Frames carry their sensor id, so
+    // the frames of all ports go into one vector.
+    static bool readFrames(const std::vector<std::unique_ptr<SerialPort>>& ports,
+                           std::vector<SensorFrame>& frames, int timeout_ms);
 }; 
\ No newline at end of file
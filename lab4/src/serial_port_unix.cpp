@@ -1,25 +1,146 @@
 #ifndef _WIN32
 
 #include "serial_port.h"
+#include "line_framer.h"
 #include <termios.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 #include <iostream>
+#include <cerrno>
 #include <cstring>
+#include <vector>
+
+namespace {
+
+// Waits until a descriptor in fds is readable or has failed. A descriptor
+// that only reports a hangup (a pty whose writer went away) would wake
+// poll() at once on every call, so it is left out of a second wait for the
+// rest of the timeout. Returns false if poll() failed.
+bool waitReadable(std::vector<struct pollfd>& fds, int timeout_ms) {
+    int ready = ::poll(fds.data(), fds.size(), timeout_ms);
+    if (ready <= 0) {
+        return ready == 0 || errno == EINTR;
+    }
+
+    bool hangup_only = true;
+    for (auto& pfd : fds) {
+        if (pfd.revents & (POLLIN | POLLERR | POLLNVAL)) {
+            hangup_only = false;
+        }
+    }
+    if (!hangup_only) {
+        return true;
+    }
+
+    for (auto& pfd : fds) {
+        if (pfd.revents & POLLHUP) {
+            pfd.fd = -1;
+        }
+        pfd.revents = 0;
+    }
+    ready = ::poll(fds.data(), fds.size(), timeout_ms);
+    return ready >= 0 || errno == EINTR;
+}
+
+// A write that finds no room for this long fails.
+constexpr int WRITE_TIMEOUT_MS = 1000;
+
+// Writes all of data to a non-blocking descriptor, which may take only part
+// of it, or nothing (EAGAIN) while the driver's buffer is full; in between
+// it waits in poll() for room. Returns false on an error or if no room
+// appears within WRITE_TIMEOUT_MS.
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n > 0) {
+            data += n;
+            size -= static_cast<size_t>(n);
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            int ready = ::poll(&pfd, 1, WRITE_TIMEOUT_MS);
+            if (ready == 0 || (ready < 0 && errno != EINTR) || (pfd.revents & (POLLERR | POLLNVAL))) {
+                return false;
+            }
+        } else if (n == 0 || errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
 
 class SerialPortUnix : public SerialPort {
 private:
     int fd;
     bool isPortOpen;
+    LineFramer framer;
+    FrameDecoder decoder;
+    std::string line;
 
-    speed_t getBaudRate(int baudRate) {
+    bool getBaudRate(int baudRate, speed_t& speed) {
         switch (baudRate) {
-            case 9600: return B9600;
-            case 19200: return B19200;
-            case 38400: return B38400;
-            case 57600: return B57600;
-            case 115200: return B115200;
-            default: return B9600;
+            case 9600: speed = B9600; return true;
+            case 19200: speed = B19200; return true;
+            case 38400: speed = B38400; return true;
+            case 57600: speed = B57600; return true;
+            case 115200: speed = B115200; return true;
+            // Not every platform defines the rates above 115200.
+#ifdef B230400
+            case 230400: speed = B230400; return true;
+#endif
+#ifdef B460800
+            case 460800: speed = B460800; return true;
+#endif
+#ifdef B500000
+            case 500000: speed = B500000; return true;
+#endif
+#ifdef B576000
+            case 576000: speed = B576000; return true;
+#endif
+#ifdef B921600
+            case 921600: speed = B921600; return true;
+#endif
+            default: return false;
+        }
+    }
+
+    // Lines and frames are read through their own ring.
+    LineFramer& framerFor(std::vector<std::string>&) { return framer; }
+    FrameDecoder& framerFor(std::vector<SensorFrame>&) { return decoder; }
+
+    // Reads until the driver has nothing left, taking records out whenever
+    // the ring fills so a burst larger than the ring is not lost.
+    template <typename Record>
+    bool drain(std::vector<Record>& records) {
+        auto& ring = framerFor(records);
+        for (;;) {
+            if (ring.writable() == 0) {
+                take(records);
+            }
+
+            ssize_t n = ::read(fd, ring.writePtr(), ring.writable());
+            if (n > 0) {
+                ring.commit(static_cast<size_t>(n));
+            } else if (n == 0 || errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            } else if (errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    void take(std::vector<std::string>& lines) {
+        while (framer.nextLine(line)) {
+            lines.push_back(line);
+        }
+    }
+
+    void take(std::vector<SensorFrame>& frames) {
+        SensorFrame frame;
+        while (decoder.nextFrame(frame)) {
+            frames.push_back(frame);
         }
     }
 
@@ -31,12 +152,18 @@ public:
     }
 
     bool open(const std::string& port, int baudRate) override {
+        speed_t baud;
+        if (!getBaudRate(baudRate, baud)) {
+            return false;
+        }
+
         fd = ::open(port.c_str(), O_RDWR | O_NOCTTY | O_NDELAY);
         if (fd == -1) {
             return false;
         }
 
-        fcntl(fd, F_SETFL, 0);
+        // Reads never block; readLines waits in poll() instead.
+        fcntl(fd, F_SETFL, O_NONBLOCK);
 
         struct termios options;
         if (tcgetattr(fd, &options) != 0) {
@@ -44,7 +171,6 @@ public:
             return false;
         }
 
-        speed_t baud = getBaudRate(baudRate);
         cfsetispeed(&options, baud);
         cfsetospeed(&options, baud);
 
@@ -55,16 +181,21 @@ public:
         options.c_cflag |= CS8;
         options.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG);
         options.c_iflag &= ~(IXON | IXOFF | IXANY);
+        // Binary frames must arrive byte for byte: no CR/NL mapping,
+        // stripping or break handling.
+        options.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL);
         options.c_oflag &= ~OPOST;
 
         options.c_cc[VMIN] = 0;
-        options.c_cc[VTIME] = 10;
+        options.c_cc[VTIME] = 0;
 
         if (tcsetattr(fd, TCSANOW, &options) != 0) {
             ::close(fd);
             return false;
         }
 
+        framer = LineFramer();
+        decoder = FrameDecoder();
         isPortOpen = true;
         return true;
     }
@@ -80,7 +211,7 @@ public:
     bool write(const std::string& data) override {
         if (!isPortOpen) return false;
 
-        return ::write(fd, data.c_str(), data.length()) != -1;
+        return writeAll(fd, data.data(), data.size());
     }
 
     bool read(std::string& data) override {
@@ -97,6 +228,39 @@ public:
         return false;
     }
 
+    bool readLines(std::vector<std::string>& lines, int timeout_ms) override {
+        if (!isPortOpen) return false;
+
+        std::vector<struct pollfd> fds = {{fd, POLLIN, 0}};
+        return waitReadable(fds, timeout_ms) && readReady(fds[0].revents, lines);
+    }
+
+    bool readFrames(std::vector<SensorFrame>& frames, int timeout_ms) override {
+        if (!isPortOpen) return false;
+
+        std::vector<struct pollfd> fds = {{fd, POLLIN, 0}};
+        return waitReadable(fds, timeout_ms) && readReady(fds[0].revents, frames);
+    }
+
+    int handle() const {
+        return fd;
+    }
+
+    // Handles what poll() reported for this port.
+    template <typename Record>
+    bool readReady(short revents, std::vector<Record>& records) {
+        if (revents & (POLLERR | POLLNVAL)) {
+            return false;
+        }
+        if (!(revents & POLLIN)) {
+            return true;
+        }
+
+        bool ok = drain(records);
+        take(records);
+        return ok;
+    }
+
     bool isOpen() const override {
         return isPortOpen;
     }
@@ -106,4 +270,49 @@ std::unique_ptr<SerialPort> SerialPort::create() {
     return std::make_unique<SerialPortUnix>();
 }
 
-#endif 
\ No newline at end of file
+namespace {
+
+// One poll() over every port, so a reading on any of them is handled as
+// soon as it arrives, however many ports there are. records(i) is where
+// the records of ports[i] go.
+template <typename Records>
+bool readPorts(const std::vector<std::unique_ptr<SerialPort>>& ports, int timeout_ms, Records records) {
+    std::vector<struct pollfd> fds(ports.size());
+    bool any_open = false;
+    for (size_t i = 0; i < ports.size(); ++i) {
+        auto* port = static_cast<SerialPortUnix*>(ports[i].get());
+        // poll() ignores negative descriptors.
+        fds[i] = {port->isOpen() ? port->handle() : -1, POLLIN, 0};
+        any_open = any_open || port->isOpen();
+    }
+    if (!any_open) {
+        return false;
+    }
+
+    if (!waitReadable(fds, timeout_ms)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < ports.size(); ++i) {
+        auto* port = static_cast<SerialPortUnix*>(ports[i].get());
+        if (fds[i].revents && !port->readReady(fds[i].revents, records(i))) {
+            port->close();
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool SerialPort::readLines(const std::vector<std::unique_ptr<SerialPort>>& ports,
+                           std::vector<std::vector<std::string>>& lines, int timeout_ms) {
+    lines.resize(ports.size());
+    return readPorts(ports, timeout_ms, [&](size_t i) -> std::vector<std::string>& { return lines[i]; });
+}
+
+bool SerialPort::readFrames(const std::vector<std::unique_ptr<SerialPort>>& ports,
+                            std::vector<SensorFrame>& frames, int timeout_ms) {
+    return readPorts(ports, timeout_ms, [&](size_t) -> std::vector<SensorFrame>& { return frames; });
+}
+
+#endif
@@ -1,17 +1,89 @@
 #ifdef _WIN32
 
 #include "serial_port.h"
+#include "line_framer.h"
 #include <windows.h>
 #include <setupapi.h>
+#include <algorithm>
 #include <iostream>
 
 class SerialPortWin : public SerialPort {
 private:
     HANDLE hSerial;
     bool isPortOpen;
+    int lineTimeout;
+    LineFramer framer;
+    FrameDecoder decoder;
+    std::string line;
+
+    // ReadFile returns as soon as any byte arrives, or after timeout_ms.
+    bool setLineTimeout(int timeout_ms) {
+        if (timeout_ms == lineTimeout) {
+            return true;
+        }
+
+        COMMTIMEOUTS timeouts = {0};
+        timeouts.ReadIntervalTimeout = MAXDWORD;
+        timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+        timeouts.ReadTotalTimeoutConstant = static_cast<DWORD>((std::max)(timeout_ms, 1));
+        timeouts.WriteTotalTimeoutConstant = 50;
+        timeouts.WriteTotalTimeoutMultiplier = 10;
+
+        if (!SetCommTimeouts(hSerial, &timeouts)) {
+            return false;
+        }
+        lineTimeout = timeout_ms;
+        return true;
+    }
+
+    void take(std::vector<std::string>& lines) {
+        while (framer.nextLine(line)) {
+            lines.push_back(line);
+        }
+    }
+
+    void take(std::vector<SensorFrame>& frames) {
+        SensorFrame frame;
+        while (decoder.nextFrame(frame)) {
+            frames.push_back(frame);
+        }
+    }
+
+    // Lines and frames are read through their own ring.
+    LineFramer& framerFor(std::vector<std::string>&) { return framer; }
+    FrameDecoder& framerFor(std::vector<SensorFrame>&) { return decoder; }
+
+    template <typename Record>
+    bool readRecords(std::vector<Record>& records, int timeout_ms) {
+        if (!isPortOpen || !setLineTimeout(timeout_ms)) return false;
+
+        auto& ring = framerFor(records);
+        DWORD bytesRead = 0;
+        if (!ReadFile(hSerial, ring.writePtr(), static_cast<DWORD>(ring.writable()), &bytesRead, nullptr)) {
+            return false;
+        }
+        ring.commit(bytesRead);
+
+        // Drain whatever else the driver has queued without waiting again.
+        DWORD errors;
+        COMSTAT status;
+        while (bytesRead > 0 && ClearCommError(hSerial, &errors, &status) && status.cbInQue > 0) {
+            if (ring.writable() == 0) {
+                take(records);
+            }
+            DWORD chunk = (std::min)(status.cbInQue, static_cast<DWORD>(ring.writable()));
+            if (!ReadFile(hSerial, ring.writePtr(), chunk, &bytesRead, nullptr)) {
+                return false;
+            }
+            ring.commit(bytesRead);
+        }
+
+        take(records);
+        return true;
+    }
 
 public:
-    SerialPortWin() : hSerial(INVALID_HANDLE_VALUE), isPortOpen(false) {}
+    SerialPortWin() : hSerial(INVALID_HANDLE_VALUE), isPortOpen(false), lineTimeout(-1) {}
 
     ~SerialPortWin() override {
         close();
@@ -61,6 +133,9 @@ public:
             return false;
         }
 
+        framer = LineFramer();
+        decoder = FrameDecoder();
+        lineTimeout = -1;
         isPortOpen = true;
         return true;
     }
@@ -76,8 +151,19 @@ public:
     bool write(const std::string& data) override {
         if (!isPortOpen) return false;
 
-        DWORD bytesWritten;
-        return WriteFile(hSerial, data.c_str(), data.length(), &bytesWritten, nullptr) != 0;
+        // A write that runs into the write timeouts above still succeeds,
+        // with only part of data written; go on until a write takes nothing.
+        const char* p = data.data();
+        size_t left = data.size();
+        while (left > 0) {
+            DWORD bytesWritten = 0;
+            if (!WriteFile(hSerial, p, static_cast<DWORD>(left), &bytesWritten, nullptr) || bytesWritten == 0) {
+                return false;
+            }
+            p += bytesWritten;
+            left -= bytesWritten;
+        }
+        return true;
     }
 
     bool read(std::string& data) override {
@@ -96,6 +182,14 @@ public:
         return false;
     }
 
+    bool readLines(std::vector<std::string>& lines, int timeout_ms) override {
+        return readRecords(lines, timeout_ms);
+    }
+
+    bool readFrames(std::vector<SensorFrame>& frames, int timeout_ms) override {
+        return readRecords(frames, timeout_ms);
+    }
+
     bool isOpen() const override {
         return isPortOpen;
     }
@@ -105,4 +199,61 @@ std::unique_ptr<SerialPort> SerialPort::create() {
     return std::make_unique<SerialPortWin>();
 }
 
-#endif 
\ No newline at end of file
+namespace {
+
+bool readFrom(SerialPort& port, std::vector<std::string>& lines) {
+    return port.readLines(lines, 1);
+}
+
+bool readFrom(SerialPort& port, std::vector<SensorFrame>& frames) {
+    return port.readFrames(frames, 1);
+}
+
+// COM ports have no readiness wait that spans several handles short of
+// overlapped I/O, so the ports are read in turn with a 1 ms timeout each
+// until one of them yields a record or timeout_ms has passed. records(i)
+// is where the records of ports[i] go.
+template <typename Records>
+bool readPorts(const std::vector<std::unique_ptr<SerialPort>>& ports, int timeout_ms, Records records) {
+    ULONGLONG deadline = GetTickCount64() + static_cast<ULONGLONG>((std::max)(timeout_ms, 0));
+
+    for (;;) {
+        bool any_open = false;
+        bool any_records = false;
+        for (size_t i = 0; i < ports.size(); ++i) {
+            if (!ports[i]->isOpen()) {
+                continue;
+            }
+            auto& port_records = records(i);
+            size_t before = port_records.size();
+            if (!readFrom(*ports[i], port_records)) {
+                ports[i]->close();
+                continue;
+            }
+            any_open = true;
+            any_records = any_records || port_records.size() > before;
+        }
+
+        if (!any_open) {
+            return false;
+        }
+        if (any_records || GetTickCount64() >= deadline) {
+            return true;
+        }
+    }
+}
+
+} // namespace
+
+bool SerialPort::readLines(const std::vector<std::unique_ptr<SerialPort>>& ports,
+                           std::vector<std::vector<std::string>>& lines, int timeout_ms) {
+    lines.resize(ports.size());
+    return readPorts(ports, timeout_ms, [&](size_t i) -> std::vector<std::string>& { return lines[i]; });
+}
+
+bool SerialPort::readFrames(const std::vector<std::unique_ptr<SerialPort>>& ports,
+                            std::vector<SensorFrame>& frames, int timeout_ms) {
+    return readPorts(ports, timeout_ms, [&](size_t) -> std::vector<SensorFrame>& { return frames; });
+}
+
+#endif
@@ -0,0 +1,366 @@
+#include "temp_log.h"
+#include "reading_parser.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+class TextLogWriter : public TempLogWriter {
+private:
+    std::ofstream file;
+    uint64_t data_size;
+
+public:
+    TextLogWriter() : data_size(0) {}
+
+    bool open(const fs::path& path) override {
+        std::error_code ec;
+        uintmax_t size = fs::file_size(path, ec);
+        data_size = ec ? 0 : size;
+
+        // Binary mode keeps "\n" one byte on every platform, so offsets match the file.
+        file.open(path, std::ios::app | std::ios::binary);
+        return file.is_open();
+    }
+
+    void close() override {
+        if (file.is_open()) {
+            file.close();
+        }
+    }
+
+    bool append(const TempReading& reading) override {
+        if (!file.is_open()) return false;
+
+        std::ostringstream line;
+        line << reading.timestamp << " " << reading.temperature << "\n";
+        file << line.str() << std::flush;
+        data_size += line.str().size();
+        return static_cast<bool>(file);
+    }
+
+    bool isOpen() const override {
+        return file.is_open();
+    }
+
+    uint64_t dataSize() const override {
+        return data_size;
+    }
+};
+
+class BinaryLogWriter : public TempLogWriter {
+private:
+    std::fstream file;
+    uint64_t record_count;
+
+    bool writeHeader() {
+        BinaryLogHeader header;
+        std::memcpy(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic));
+        header.version = BINARY_LOG_VERSION;
+        header.record_count = record_count;
+
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        return static_cast<bool>(file);
+    }
+
+public:
+    BinaryLogWriter() : record_count(0) {}
+
+    bool open(const fs::path& path) override {
+        std::error_code ec;
+        record_count = 0;
+
+        if (fs::exists(path, ec) && fs::file_size(path, ec) >= sizeof(BinaryLogHeader)) {
+            BinaryLogHeader header;
+            std::ifstream in(path, std::ios::binary);
+            in.read(reinterpret_cast<char*>(&header), sizeof(header));
+            if (!in || std::memcmp(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic)) != 0 ||
+                header.version != BINARY_LOG_VERSION) {
+                return false;
+            }
+            in.close();
+
+            record_count = header.record_count;
+            // Drop a record that was only partially written before a crash.
+            fs::resize_file(path, sizeof(BinaryLogHeader) + record_count * sizeof(BinaryLogRecord), ec);
+            if (ec) {
+                return false;
+            }
+            file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+            return file.is_open();
+        }
+
+        file.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.close();
+        file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+        return file.is_open() && writeHeader() && static_cast<bool>(file.flush());
+    }
+
+    void close() override {
+        if (file.is_open()) {
+            file.close();
+        }
+    }
+
+    bool append(const TempReading& reading) override {
+        if (!file.is_open()) return false;
+
+        BinaryLogRecord record;
+        record.timestamp = static_cast<int64_t>(reading.timestamp);
+        record.temperature = reading.temperature;
+
+        file.seekp(sizeof(BinaryLogHeader) + record_count * sizeof(BinaryLogRecord));
+        file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        if (!file) {
+            return false;
+        }
+
+        ++record_count;
+        uint64_t count = record_count;
+        file.seekp(offsetof(BinaryLogHeader, record_count));
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        file.flush();
+        return static_cast<bool>(file);
+    }
+
+    bool isOpen() const override {
+        return file.is_open();
+    }
+
+    uint64_t dataSize() const override {
+        return record_count * sizeof(BinaryLogRecord);
+    }
+};
+
+bool recordBefore(const BinaryLogRecord& record, time_t timestamp) {
+    return record.timestamp < static_cast<int64_t>(timestamp);
+}
+
+bool timestampBefore(time_t timestamp, const BinaryLogRecord& record) {
+    return static_cast<int64_t>(timestamp) < record.timestamp;
+}
+
+} // namespace
+
+const char* logExtension(LogFormat format) {
+    return format == LogFormat::Binary ? ".bin" : ".log";
+}
+
+LogFormat detectLogFormat(const fs::path& path) {
+    char magic[sizeof(BINARY_LOG_MAGIC)] = {};
+    std::ifstream in(path, std::ios::binary);
+    in.read(magic, sizeof(magic));
+    if (in && std::memcmp(magic, BINARY_LOG_MAGIC, sizeof(magic)) == 0) {
+        return LogFormat::Binary;
+    }
+    return LogFormat::Text;
+}
+
+std::unique_ptr<TempLogWriter> TempLogWriter::create(LogFormat format) {
+    if (format == LogFormat::Binary) {
+        return std::make_unique<BinaryLogWriter>();
+    }
+    return std::make_unique<TextLogWriter>();
+}
+
+MappedTempLog::MappedTempLog()
+    : data_(nullptr), length_(0), records_(nullptr), count_(0) {}
+
+MappedTempLog::~MappedTempLog() {
+    close();
+}
+
+bool MappedTempLog::open(const fs::path& path) {
+    close();
+
+    std::error_code ec;
+    uintmax_t file_size = fs::file_size(path, ec);
+    if (ec || file_size < sizeof(BinaryLogHeader)) {
+        return false;
+    }
+
+    length_ = static_cast<size_t>(file_size);
+    if (!map(path)) {
+        length_ = 0;
+        return false;
+    }
+
+    const auto* header = static_cast<const BinaryLogHeader*>(data_);
+    if (std::memcmp(header->magic, BINARY_LOG_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != BINARY_LOG_VERSION) {
+        close();
+        return false;
+    }
+
+    size_t available = (length_ - sizeof(BinaryLogHeader)) / sizeof(BinaryLogRecord);
+    count_ = static_cast<size_t>(std::min<uint64_t>(header->record_count, available));
+    records_ = reinterpret_cast<const BinaryLogRecord*>(
+        static_cast<const char*>(data_) + sizeof(BinaryLogHeader));
+    return true;
+}
+
+void MappedTempLog::close() {
+    if (data_) {
+        unmap();
+    }
+    data_ = nullptr;
+    length_ = 0;
+    records_ = nullptr;
+    count_ = 0;
+}
+
+const BinaryLogRecord* MappedTempLog::lowerBound(time_t timestamp) const {
+    return std::lower_bound(begin(), end(), timestamp, recordBefore);
+}
+
+const BinaryLogRecord* MappedTempLog::upperBound(time_t timestamp) const {
+    return std::upper_bound(begin(), end(), timestamp, timestampBefore);
+}
+
+bool forEachTempRecord(const fs::path& path, LogFormat format,
+                       const std::function<void(const TempReading&, uint64_t)>& onRecord) {
+    if (format == LogFormat::Binary) {
+        MappedTempLog log;
+        if (!log.open(path)) {
+            return false;
+        }
+        uint64_t offset = 0;
+        for (const auto& record : log) {
+            onRecord({static_cast<time_t>(record.timestamp), record.temperature}, offset);
+            offset += sizeof(BinaryLogRecord);
+        }
+        return true;
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+
+    // The file is parsed in place a chunk at a time; a line cut by the end
+    // of a chunk is moved to the front of the buffer for the next one.
+    std::vector<char> buffer(64 * 1024);
+    size_t filled = 0;
+    uint64_t offset = 0;
+    ParseStats stats;
+    auto onReading = [&](time_t timestamp, double temperature, size_t line_offset) {
+        onRecord({timestamp, temperature}, offset + line_offset);
+    };
+    for (;;) {
+        in.read(buffer.data() + filled, static_cast<std::streamsize>(buffer.size() - filled));
+        filled += static_cast<size_t>(in.gcount());
+
+        size_t consumed = parseReadings(std::string_view(buffer.data(), filled), stats, onReading);
+        if (!in) {
+            // The last line may have no "\n".
+            time_t timestamp;
+            double temperature;
+            if (parseReading(std::string_view(buffer.data() + consumed, filled - consumed),
+                             timestamp, temperature) == ParseStatus::Ok) {
+                onReading(timestamp, temperature, consumed);
+            }
+            return true;
+        }
+
+        if (consumed == 0 && filled == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+            continue;
+        }
+        std::memmove(buffer.data(), buffer.data() + consumed, filled - consumed);
+        filled -= consumed;
+        offset += consumed;
+    }
+}
+
+std::vector<TempReading> readTempLog(const fs::path& path, LogFormat format) {
+    std::vector<TempReading> readings;
+    forEachTempRecord(path, format, [&readings](const TempReading& reading, uint64_t) {
+        readings.push_back(reading);
+    });
+    return readings;
+}
+
+bool writeTempLog(const fs::path& path, LogFormat format, const std::vector<TempReading>& readings) {
+    if (format == LogFormat::Binary) {
+        // Bulk path: one header with the final count, then all records.
+        std::ofstream out(path, std::ios::trunc | std::ios::binary);
+        BinaryLogHeader header;
+        std::memcpy(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic));
+        header.version = BINARY_LOG_VERSION;
+        header.record_count = readings.size();
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        for (const auto& reading : readings) {
+            BinaryLogRecord record;
+            record.timestamp = static_cast<int64_t>(reading.timestamp);
+            record.temperature = reading.temperature;
+            out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        }
+        return static_cast<bool>(out);
+    }
+
+    std::ofstream out(path, std::ios::trunc);
+    for (const auto& reading : readings) {
+        out << reading.timestamp << " " << reading.temperature << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+bool dropTempLogHead(const fs::path& path, LogFormat format, uint64_t data_offset) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+
+    uint64_t header_size = 0;
+    BinaryLogHeader header;
+    if (format == LogFormat::Binary) {
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!in) {
+            return false;
+        }
+        header_size = sizeof(header);
+        uint64_t dropped = data_offset / sizeof(BinaryLogRecord);
+        header.record_count = header.record_count > dropped ? header.record_count - dropped : 0;
+    }
+
+    fs::path tmp_path = path;
+    tmp_path += ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream out(tmp_path, std::ios::trunc | std::ios::binary);
+        if (format == LogFormat::Binary) {
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+
+        // Copied by hand: operator<< on a stream buffer fails when there is
+        // nothing left to copy, which is the normal case once every record
+        // has expired.
+        in.seekg(static_cast<std::streamoff>(header_size + data_offset));
+        char buffer[64 * 1024];
+        while (in && out) {
+            in.read(buffer, sizeof(buffer));
+            out.write(buffer, in.gcount());
+        }
+        out.flush();
+        if (!out || !in.eof()) {
+            out.close();
+            fs::remove(tmp_path, ec);
+            return false;
+        }
+    }
+    in.close();
+
+    fs::rename(tmp_path, path, ec);
+    if (ec) {
+        fs::remove(tmp_path, ec);
+        return false;
+    }
+    return true;
+}
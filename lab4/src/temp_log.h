@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "temp_reading.h"
+
+namespace fs = std::filesystem;
+
+enum class LogFormat {
+    Text,   // "timestamp temperature" lines
+    Binary  // BinaryLogHeader followed by BinaryLogRecord entries
+};
+
+// Binary logs use the host byte order (little-endian on all supported targets).
+// record_count is updated after every append, so bytes past the last counted
+// record are an interrupted write and are ignored by readers.
+struct BinaryLogHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t record_count;
+};
+
+struct BinaryLogRecord {
+    int64_t timestamp;
+    double temperature;
+};
+
+static_assert(sizeof(BinaryLogHeader) == 16, "binary log header must be 16 bytes");
+static_assert(sizeof(BinaryLogRecord) == 16, "binary log record must be 16 bytes");
+
+constexpr char BINARY_LOG_MAGIC[4] = {'T', 'M', 'P', 'L'};
+constexpr uint32_t BINARY_LOG_VERSION = 1;
+
+const char* logExtension(LogFormat format);
+LogFormat detectLogFormat(const fs::path& path);
+
+class TempLogWriter {
+public:
+    virtual ~TempLogWriter() = default;
+
+    virtual bool open(const fs::path& path) = 0;
+
+    virtual void close() = 0;
+
+    virtual bool append(const TempReading& reading) = 0;
+
+    virtual bool isOpen() const = 0;
+
+    // Bytes of record data in the file, not counting the binary header.
+    virtual uint64_t dataSize() const = 0;
+
+    static std::unique_ptr<TempLogWriter> create(LogFormat format);
+};
+
+// Read-only memory mapping of a binary log. Records are sorted by timestamp
+// as long as they were appended in order, which is what the monitor does.
+class MappedTempLog {
+public:
+    MappedTempLog();
+    ~MappedTempLog();
+
+    MappedTempLog(const MappedTempLog&) = delete;
+    MappedTempLog& operator=(const MappedTempLog&) = delete;
+
+    bool open(const fs::path& path);
+    void close();
+    bool isOpen() const { return data_ != nullptr; }
+
+    size_t size() const { return count_; }
+    const BinaryLogRecord* begin() const { return records_; }
+    const BinaryLogRecord* end() const { return records_ + count_; }
+
+    // First record with timestamp >= the given one.
+    const BinaryLogRecord* lowerBound(time_t timestamp) const;
+    // First record with timestamp > the given one.
+    const BinaryLogRecord* upperBound(time_t timestamp) const;
+
+private:
+    bool map(const fs::path& path);
+    void unmap();
+
+    void* data_;
+    size_t length_;
+    const BinaryLogRecord* records_;
+    size_t count_;
+};
+
+// Calls onRecord for every record together with its offset in the record data.
+bool forEachTempRecord(const fs::path& path, LogFormat format,
+                       const std::function<void(const TempReading&, uint64_t)>& onRecord);
+std::vector<TempReading> readTempLog(const fs::path& path, LogFormat format);
+bool writeTempLog(const fs::path& path, LogFormat format, const std::vector<TempReading>& readings);
+// Removes record data before data_offset by copying the rest into a new file.
+bool dropTempLogHead(const fs::path& path, LogFormat format, uint64_t data_offset);
@@ -6,27 +6,63 @@
 #include <thread>
 #include <ctime>
 #include <filesystem>
-#include <numeric>
 #include <map>
-#include <sstream>
+#include <cstdlib>
 #include "serial_port.h"
+#include "reading_parser.h"
+#include "retained_log.h"
+#include "running_stats.h"
+#include "segmented_log.h"
+#include "temp_log.h"
+#include "temp_reading.h"
 
 namespace fs = std::filesystem;
 
-struct TempReading {
-    time_t timestamp;
-    double temperature;
-};
-
 class TemperatureMonitor {
 private:
+    // Logs and running statistics of one sensor, kept in logs/sensor_<id>/.
+    struct Sensor {
+        int id;
+        std::unique_ptr<SegmentedLog> raw_log;
+        std::unique_ptr<RetainedLog> hourly_log;
+        fs::path daily_log_path;
+        time_t current_hour = -1;
+        RunningStats hourly_stats;
+        time_t current_day = -1;
+        RunningStats daily_stats;
+    };
+
     fs::path logs_dir;
-    fs::path raw_log_path;
-    fs::path hourly_log_path;
-    fs::path daily_log_path;
-    std::unique_ptr<SerialPort> serialPort;
-    std::vector<TempReading> hourly_readings;
-    std::map<time_t, std::vector<double>> daily_readings;
+    LogFormat log_format;
+    time_t compact_after;
+    bool binaryFrames;
+    std::map<int, Sensor> sensors;
+    std::vector<std::string> portNames;
+    std::vector<std::unique_ptr<SerialPort>> serialPorts;
+
+    // Logs of a sensor are opened when its first reading arrives.
+    Sensor& sensorFor(int id) {
+        auto it = sensors.find(id);
+        if (it != sensors.end()) {
+            return it->second;
+        }
+
+        Sensor sensor;
+        sensor.id = id;
+        fs::path dir = logs_dir / ("sensor_" + std::to_string(id));
+        try {
+            fs::create_directories(dir);
+        } catch (const fs::filesystem_error& e) {
+            std::cerr << "Failed to create logs directory: " << e.what() << std::endl;
+            throw;
+        }
+        sensor.raw_log = std::make_unique<SegmentedLog>(dir / "raw", "raw", 60*60, 24*60*60, log_format);
+        sensor.hourly_log = std::make_unique<RetainedLog>(
+            dir / (std::string("hourly_temp") + logExtension(log_format)),
+            log_format, 30*24*60*60, compact_after);
+        sensor.daily_log_path = dir / (std::string("daily_temp") + logExtension(log_format));
+        return sensors.emplace(id, std::move(sensor)).first->second;
+    }
 
     std::string getFormattedTime(time_t timestamp) {
         char buffer[26];
@@ -35,151 +71,182 @@ private:
         return std::string(buffer);
     }
 
-    void writeToRawLog(const TempReading& reading) {
-        std::vector<TempReading> readings;
-        
-        std::ifstream inFile(raw_log_path);
-        time_t timestamp;
-        double temp;
-        while (inFile >> timestamp >> temp) {
-            readings.push_back({timestamp, temp});
+    void appendToLog(const fs::path& path, const TempReading& reading) {
+        auto writer = TempLogWriter::create(log_format);
+        if (!writer->open(path) || !writer->append(reading)) {
+            std::cerr << "Failed to write to " << path << std::endl;
         }
-        inFile.close();
-
-        readings.push_back(reading);
+    }
 
-        time_t cutoff = reading.timestamp - 24*60*60;
-        std::vector<TempReading> filtered_readings;
-        for (const auto& r : readings) {
-            if (r.timestamp >= cutoff) {
-                filtered_readings.push_back(r);
-            }
-        }
+    void writeToRawLog(Sensor& sensor, const TempReading& reading) {
+        sensor.raw_log->append(reading);
+    }
 
-        std::ofstream outFile(raw_log_path, std::ios::trunc);
-        for (const auto& r : filtered_readings) {
-            outFile << r.timestamp << " " << r.temperature << std::endl;
-        }
+    void reportStats(const Sensor& sensor, const char* bucket, time_t start, const RunningStats& stats) {
+        std::cout << "Sensor " << sensor.id << ": " << bucket << " " << getFormattedTime(start)
+                  << ": avg " << stats.mean()
+                  << ", min " << stats.min()
+                  << ", max " << stats.max()
+                  << ", stddev " << stats.stddev()
+                  << " (" << stats.count() << " readings)" << std::endl;
     }
 
-    void processHourlyAverage(const TempReading& reading) {
-        hourly_readings.push_back(reading);
-        
-        struct tm* timeinfo = localtime(&reading.timestamp);
-        int current_hour = timeinfo->tm_hour;
-        
-        if (!hourly_readings.empty()) {
-            timeinfo = localtime(&hourly_readings.front().timestamp);
-            int first_hour = timeinfo->tm_hour;
-            
-            if (current_hour != first_hour || hourly_readings.size() >= 3600) {
-                double sum = std::accumulate(hourly_readings.begin(), hourly_readings.end(), 0.0,
-                    [](double acc, const TempReading& r) { return acc + r.temperature; });
-                double average = sum / hourly_readings.size();
+    void closeHour(Sensor& sensor) {
+        sensor.hourly_log->append({sensor.current_hour, sensor.hourly_stats.mean()});
+        reportStats(sensor, "Hour", sensor.current_hour, sensor.hourly_stats);
 
-                std::ofstream outFile(hourly_log_path, std::ios::app);
-                outFile << reading.timestamp << " " << average << std::endl;
+        time_t day = sensor.current_hour - sensor.current_hour % (24*60*60);
+        if (sensor.daily_stats.count() > 0 && day != sensor.current_day) {
+            closeDay(sensor);
+        }
+        sensor.current_day = day;
+        sensor.daily_stats.merge(sensor.hourly_stats);
+        sensor.hourly_stats.reset();
+    }
 
-                daily_readings[reading.timestamp - reading.timestamp % (24*60*60)].push_back(average);
+    void closeDay(Sensor& sensor) {
+        appendToLog(sensor.daily_log_path, {sensor.current_day, sensor.daily_stats.mean()});
+        reportStats(sensor, "Day", sensor.current_day, sensor.daily_stats);
+        sensor.daily_stats.reset();
+    }
 
-                hourly_readings.clear();
-            }
+    void processHourlyAverage(Sensor& sensor, const TempReading& reading) {
+        time_t hour = reading.timestamp - reading.timestamp % (60*60);
+        if (sensor.hourly_stats.count() > 0 && hour != sensor.current_hour) {
+            closeHour(sensor);
         }
+        sensor.current_hour = hour;
+        sensor.hourly_stats.add(reading.temperature);
 
-        std::vector<std::string> hourly_lines;
-        std::ifstream hourly_file(hourly_log_path);
-        std::string line;
-        time_t month_ago = reading.timestamp - 30*24*60*60;
-        
-        while (std::getline(hourly_file, line)) {
-            time_t line_time;
-            std::istringstream iss(line);
-            if (iss >> line_time && line_time >= month_ago) {
-                hourly_lines.push_back(line);
-            }
-        }
-        
-        std::ofstream outFile(hourly_log_path, std::ios::trunc);
-        for (const auto& l : hourly_lines) {
-            outFile << l << std::endl;
-        }
+        sensor.hourly_log->enforceRetention(reading.timestamp);
     }
 
-    void processDailyAverage(time_t current_time) {
-        time_t current_day = current_time - current_time % (24*60*60);
-        
-        std::map<time_t, std::vector<double>> remaining_readings;
-        for (const auto& pair : daily_readings) {
-            if (pair.first < current_day) {
-                double sum = std::accumulate(pair.second.begin(), pair.second.end(), 0.0);
-                double average = sum / pair.second.size();
-
-                std::ofstream outFile(daily_log_path, std::ios::app);
-                outFile << pair.first << " " << average << std::endl;
-            } else {
-                remaining_readings[pair.first] = pair.second;
-            }
+    void processDailyAverage(Sensor& sensor, time_t current_time) {
+        time_t day = current_time - current_time % (24*60*60);
+        if (sensor.daily_stats.count() > 0 && day != sensor.current_day) {
+            closeDay(sensor);
         }
-        daily_readings = remaining_readings;
+    }
+
+    void processReading(Sensor& sensor, const TempReading& reading) {
+        writeToRawLog(sensor, reading);
+        processHourlyAverage(sensor, reading);
+        processDailyAverage(sensor, reading.timestamp);
     }
 
 public:
-    TemperatureMonitor(const std::string& portName) {
+    // With text lines each port is one sensor and its id is the port's
+    // position in portNames; binary frames carry their own sensor id.
+    TemperatureMonitor(const std::vector<std::string>& ports, LogFormat format, time_t compact_after,
+                       int baudRate, bool binaryFrames)
+        : log_format(format), compact_after(compact_after), binaryFrames(binaryFrames), portNames(ports) {
         logs_dir = fs::current_path() / "logs";
-        raw_log_path = logs_dir / "raw_temp.log";
-        hourly_log_path = logs_dir / "hourly_temp.log";
-        daily_log_path = logs_dir / "daily_temp.log";
-
-        try {
-            fs::create_directories(logs_dir);
-        } catch (const fs::filesystem_error& e) {
-            std::cerr << "Failed to create logs directory: " << e.what() << std::endl;
-            throw;
-        }
 
-        serialPort = SerialPort::create();
-        if (!serialPort->open(portName, 9600)) {
-            throw std::runtime_error("Failed to open serial port: " + portName);
+        for (const auto& portName : portNames) {
+            serialPorts.push_back(SerialPort::create());
+            if (!serialPorts.back()->open(portName, baudRate)) {
+                throw std::runtime_error("Failed to open serial port " + portName + " at " +
+                                         std::to_string(baudRate) + " baud");
+            }
         }
     }
 
     void run() {
-        std::cout << "Temperature monitor started. Reading from serial port..." << std::endl;
-        
-        std::string data;
+        std::cout << "Temperature monitor started. Reading from " << serialPorts.size()
+                  << " serial port(s)..." << std::endl;
+
+        // All ports are waited on together; readings are handled as they arrive.
+        std::vector<std::vector<std::string>> lines(serialPorts.size());
+        std::vector<SensorFrame> frames;
+        std::vector<bool> portOpen(serialPorts.size(), true);
         while (true) {
-            if (serialPort->read(data)) {
-                std::istringstream iss(data);
-                TempReading reading;
-                
-                if (iss >> reading.timestamp >> reading.temperature) {
-                    writeToRawLog(reading);
-                    processHourlyAverage(reading);
-                    processDailyAverage(reading.timestamp);
-                }
+            for (auto& portLines : lines) {
+                portLines.clear();
+            }
+            frames.clear();
+            bool ok = binaryFrames ? SerialPort::readFrames(serialPorts, frames, 1000)
+                                   : SerialPort::readLines(serialPorts, lines, 1000);
+            if (!ok) {
+                throw std::runtime_error("No serial port left to read from");
+            }
+
+            for (const auto& frame : frames) {
+                processReading(sensorFor(frame.sensor), {frame.timestamp, frame.temperature});
             }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            for (size_t i = 0; i < serialPorts.size(); ++i) {
+                for (const auto& line : lines[i]) {
+                    TempReading reading;
+                    ParseStatus status = parseReading(line, reading.timestamp, reading.temperature);
+                    if (status == ParseStatus::Ok) {
+                        processReading(sensorFor(static_cast<int>(i)), reading);
+                    } else if (status != ParseStatus::Empty) {
+                        std::cerr << "Sensor " << i << ": skipped malformed reading (" << parseStatusName(status)
+                                  << "): " << line << std::endl;
+                    }
+                }
+
+                if (portOpen[i] && !serialPorts[i]->isOpen()) {
+                    std::cerr << "Lost serial port " << portNames[i];
+                    if (!binaryFrames) {
+                        std::cerr << " (sensor " << i << ")";
+                    }
+                    std::cerr << std::endl;
+                    portOpen[i] = false;
+                }
+            }
         }
     }
 
     ~TemperatureMonitor() {
-        if (serialPort) {
+        for (auto& serialPort : serialPorts) {
             serialPort->close();
         }
     }
 };
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cout << "Usage: " << argv[0] << " <port>" << std::endl;
+    LogFormat format = LogFormat::Text;
+    time_t compact_after = 24*60*60;
+    int baudRate = 9600;
+    bool binaryFrames = false;
+    std::vector<std::string> portNames;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--binary") {
+            format = LogFormat::Binary;
+        } else if (arg == "--compact-after" && i + 1 < argc) {
+            compact_after = static_cast<time_t>(std::atol(argv[++i])) * 60*60;
+        } else if (arg == "--baud" && i + 1 < argc) {
+            baudRate = std::atoi(argv[++i]);
+        } else if (arg == "--protocol" && i + 1 < argc && (argv[i + 1] == std::string("text") ||
+                                                           argv[i + 1] == std::string("binary"))) {
+            binaryFrames = argv[++i] == std::string("binary");
+        } else if (!arg.empty() && arg[0] == '-') {
+            portNames.clear();
+            break;
+        } else {
+            portNames.push_back(arg);
+        }
+    }
+
+    if (portNames.empty()) {
+        std::cout << "Usage: " << argv[0] << " [--binary] [--compact-after <hours>] [--baud N] [--protocol text|binary] <port>..." << std::endl;
         std::cout << "Example: " << argv[0] << " COM1    (on Windows)" << std::endl;
         std::cout << "Example: " << argv[0] << " /dev/ttyUSB0    (on Unix)" << std::endl;
+        std::cout << "Example: " << argv[0] << " /dev/ttyUSB0 /dev/ttyUSB1    (two sensors)" << std::endl;
+        std::cout << "  --binary                   write logs as fixed-size binary records" << std::endl;
+        std::cout << "  --compact-after <hours>    let expired hourly records pile up this long" << std::endl;
+        std::cout << "                             before rewriting the hourly log (default 24)" << std::endl;
+        std::cout << "  --baud N                   serial line speed, 9600 to 921600 (default 9600)" << std::endl;
+        std::cout << "  --protocol text|binary     text lines, one sensor per port, or binary frames" << std::endl;
+        std::cout << "                             carrying their own sensor id (default text)" << std::endl;
         return 1;
     }
 
     try {
-        TemperatureMonitor monitor(argv[1]);
+        TemperatureMonitor monitor(portNames, format, compact_after, baudRate, binaryFrames);
         monitor.run();
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
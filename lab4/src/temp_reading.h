@@ -0,0 +1,8 @@
+#pragma once
+
+#include <ctime>
+
+struct TempReading {
+    time_t timestamp;
+    double temperature;
+};
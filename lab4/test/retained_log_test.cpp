@@ -0,0 +1,72 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "../src/retained_log.h"
+#include "../src/temp_log.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+const time_t DAY = 24*60*60;
+
+// Every record is past retention + compact_after, e.g. after a month of
+// downtime: compaction must leave an empty log and not be retried.
+void test_all_records_expired(LogFormat format) {
+    std::cout << "Test: all records expired (" << (format == LogFormat::Binary ? "binary" : "text") << ")" << std::endl;
+
+    fs::path dir = fs::temp_directory_path() / "retained_log_test";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    fs::path path = dir / (std::string("hourly_temp") + logExtension(format));
+    fs::path tmp_path = path;
+    tmp_path += ".tmp";
+
+    std::ostringstream errors;
+    std::streambuf* saved = std::cerr.rdbuf(errors.rdbuf());
+    {
+        RetainedLog log(path, format, 30*DAY, DAY);
+        for (time_t hour = 0; hour < 24; ++hour) {
+            log.append({1700000000 + hour*60*60, 20.0 + hour});
+        }
+
+        time_t now = 1700000000 + 60*DAY;
+        log.enforceRetention(now);
+        auto first_write = fs::last_write_time(path);
+        log.enforceRetention(now + 1);
+        check(fs::last_write_time(path) == first_write, "log is not rewritten again");
+
+        log.append({now, 42.0});
+        log.enforceRetention(now + 2);
+    }
+    std::cerr.rdbuf(saved);
+
+    check(errors.str().empty(), "no errors, got: " + errors.str());
+    check(!fs::exists(tmp_path), "no temporary file is left behind");
+    auto readings = readTempLog(path, format);
+    check(readings.size() == 1, "only the new reading is left, got " + std::to_string(readings.size()));
+    check(!readings.empty() && readings[0].temperature == 42.0, "the new reading is intact");
+
+    fs::remove_all(dir);
+}
+
+} // namespace
+
+int main() {
+    test_all_records_expired(LogFormat::Text);
+    test_all_records_expired(LogFormat::Binary);
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All tests passed" << std::endl;
+    return 0;
+}
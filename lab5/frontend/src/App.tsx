@@ -1,7 +1,15 @@
 import React, { useEffect, useState } from "react";
 import TemperatureChart from "./components/TemperatureChart";
-import { fetchCurrentTemperature, fetchTemperatureHistory } from "./api";
-import type { TemperatureReading, CurrentTemperature } from "./types";
+import {
+  fetchSensors,
+  fetchTemperatureHistory,
+  subscribeTemperatureStream,
+} from "./api";
+import type {
+  TemperatureReading,
+  CurrentTemperature,
+  ClosedBucket,
+} from "./types";
 
 const formatTimestamp = (
   timestamp: number,
@@ -25,17 +33,40 @@ const App: React.FC = () => {
   );
   const [hourlyData, setHourlyData] = useState<TemperatureReading[]>([]);
   const [dailyData, setDailyData] = useState<TemperatureReading[]>([]);
+  const [sensor, setSensor] = useState(0);
+  const [sensors, setSensors] = useState<number[]>([]);
 
-  const fetchCurrent = async () => {
-    try {
-      const data = await fetchCurrentTemperature();
-      console.log("Current temperature data:", data);
-      setCurrentTemp({
-        ...data,
-        temperature: Number(data.temperature.toFixed(2)),
-      });
-    } catch (error) {
-      console.error("Failed to fetch current temperature:", error);
+  const handleReading = (data: CurrentTemperature) => {
+    setCurrentTemp({
+      ...data,
+      temperature: Number(data.temperature.toFixed(2)),
+    });
+  };
+
+  const handleBucketClosed = (
+    type: "hourly" | "daily",
+    bucket: ClosedBucket
+  ) => {
+    const reading: TemperatureReading = {
+      timestamp: bucket.timestamp,
+      temperature: Number(bucket.temperature.toFixed(2)),
+      formatted_time: formatTimestamp(bucket.timestamp, type),
+    };
+    const span = type === "hourly" ? 24 * 3600 : 30 * 86400;
+    const update = (data: TemperatureReading[]) =>
+      data
+        .filter(
+          (item) =>
+            item.timestamp !== reading.timestamp &&
+            item.timestamp > reading.timestamp - span
+        )
+        .concat(reading)
+        .sort((a, b) => a.timestamp - b.timestamp);
+
+    if (type === "hourly") {
+      setHourlyData(update);
+    } else {
+      setDailyData(update);
     }
   };
 
@@ -69,12 +100,18 @@ const App: React.FC = () => {
       const hourlyResponse = await fetchTemperatureHistory(
         "hourly",
         hourlyStart,
-        hourlyEnd
+        hourlyEnd,
+        undefined,
+        undefined,
+        sensor
       );
       const dailyResponse = await fetchTemperatureHistory(
         "daily",
         dailyStart,
-        dailyEnd
+        dailyEnd,
+        undefined,
+        undefined,
+        sensor
       );
 
       console.log("Raw hourly response:", hourlyResponse);
@@ -107,22 +144,50 @@ const App: React.FC = () => {
   };
 
   useEffect(() => {
-    fetchCurrent();
-    fetchHistory();
+    fetchSensors()
+      .then((list) => setSensors(list.map((item) => item.sensor)))
+      .catch((error) => console.error("Failed to fetch sensors:", error));
+  }, []);
 
-    const currentInterval = setInterval(fetchCurrent, 1000);
-    const historyInterval = setInterval(fetchHistory, 60000);
+  useEffect(() => {
+    setCurrentTemp(null);
+    setHourlyData([]);
+    setDailyData([]);
+    fetchHistory();
 
-    return () => {
-      clearInterval(currentInterval);
-      clearInterval(historyInterval);
-    };
-  }, []);
+    // History is loaded once per sensor; after that the server pushes every
+    // new reading and each hourly/daily bucket as it closes.
+    return subscribeTemperatureStream(
+      {
+        onReading: handleReading,
+        onBucketClosed: handleBucketClosed,
+      },
+      sensor
+    );
+  }, [sensor]);
 
   return (
     <div style={{ padding: "20px", maxWidth: "1200px", margin: "0 auto" }}>
       <h1>Temperature Monitor</h1>
 
+      {sensors.length > 1 && (
+        <div style={{ marginBottom: "20px" }}>
+          <label>
+            Sensor{" "}
+            <select
+              value={sensor}
+              onChange={(event) => setSensor(Number(event.target.value))}
+            >
+              {sensors.map((id) => (
+                <option key={id} value={id}>
+                  {id}
+                </option>
+              ))}
+            </select>
+          </label>
+        </div>
+      )}
+
       <div
         style={{
           marginBottom: "20px",
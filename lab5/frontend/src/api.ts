@@ -1,30 +1,127 @@
 import axios from "axios";
-import type { TemperatureResponse, CurrentTemperature } from "./types";
+import type {
+  TemperatureReading,
+  TemperatureResponse,
+  CurrentTemperature,
+  SensorSummary,
+  TemperatureStreamHandlers,
+} from "./types";
 
 const API_BASE_URL = "http://localhost:8080/api";
 
-export const fetchCurrentTemperature =
-  async (): Promise<CurrentTemperature> => {
-    const response = await axios.get<CurrentTemperature>(
-      `${API_BASE_URL}/temperature/current`
-    );
-    return response.data;
+export const fetchCurrentTemperature = async (
+  sensor = 0
+): Promise<CurrentTemperature> => {
+  const response = await axios.get<CurrentTemperature>(
+    `${API_BASE_URL}/temperature/current`,
+    { params: { sensor } }
+  );
+  return response.data;
+};
+
+// Every sensor that has reported, with its open hourly and daily averages.
+export const fetchSensors = async (): Promise<SensorSummary[]> => {
+  const response = await axios.get<{ sensors: SensorSummary[] }>(
+    `${API_BASE_URL}/sensors`
+  );
+  return response.data.sensors;
+};
+
+// Decodes the columnar history format (see HistoryFormat in api_handler.h):
+// "TMPC", then blocks of [varint count][count zigzag varint timestamp
+// deltas][count float32 temperatures], ended by a zero count.
+export const decodeColumnarHistory = (
+  buffer: ArrayBuffer
+): TemperatureResponse => {
+  const bytes = new Uint8Array(buffer);
+  const view = new DataView(buffer);
+  const magic = String.fromCharCode(bytes[0], bytes[1], bytes[2], bytes[3]);
+  if (magic !== "TMPC") {
+    throw new Error("Unexpected history format");
+  }
+
+  let pos = 4;
+  // Arithmetic instead of bit operations: timestamps do not fit in 32 bits.
+  const readVarint = (): number => {
+    let value = 0;
+    let scale = 1;
+    for (;;) {
+      const byte = bytes[pos++];
+      if (byte === undefined) {
+        throw new Error("Truncated history data");
+      }
+      value += (byte & 0x7f) * scale;
+      if (byte < 0x80) {
+        return value;
+      }
+      scale *= 128;
+    }
   };
 
+  const data: TemperatureReading[] = [];
+  let timestamp = 0;
+  for (let count = readVarint(); count > 0; count = readVarint()) {
+    const first = data.length;
+    for (let i = 0; i < count; i++) {
+      const zigzag = readVarint();
+      timestamp += zigzag % 2 === 1 ? -(zigzag + 1) / 2 : zigzag / 2;
+      data.push({ timestamp, temperature: 0, formatted_time: "" });
+    }
+    for (let i = 0; i < count; i++) {
+      data[first + i].temperature = view.getFloat32(pos, true);
+      pos += 4;
+    }
+  }
+  return { data };
+};
+
+// With points set, the server reduces the range to at most that many
+// representative readings (LTTB by default).
 export const fetchTemperatureHistory = async (
   type: string,
   startTime: number,
-  endTime: number
+  endTime: number,
+  points?: number,
+  method?: "lttb" | "minmax" | "avg",
+  sensor = 0
 ): Promise<TemperatureResponse> => {
-  const response = await axios.get<TemperatureResponse>(
+  const response = await axios.get<ArrayBuffer>(
     `${API_BASE_URL}/temperature/history`,
     {
       params: {
+        sensor,
         type,
         start: startTime,
         end: endTime,
+        format: "binary",
+        points,
+        method,
       },
+      responseType: "arraybuffer",
     }
   );
-  return response.data;
+  return decodeColumnarHistory(response.data);
+};
+
+// Opens the server-sent event stream of one sensor, or of all sensors when
+// sensor is omitted; the browser reconnects on its own.
+// Returns a function that closes the stream.
+export const subscribeTemperatureStream = (
+  handlers: TemperatureStreamHandlers,
+  sensor?: number
+): (() => void) => {
+  const query = sensor === undefined ? "" : `?sensor=${sensor}`;
+  const source = new EventSource(`${API_BASE_URL}/temperature/stream${query}`);
+
+  source.addEventListener("reading", (event) => {
+    handlers.onReading(JSON.parse((event as MessageEvent).data));
+  });
+  source.addEventListener("hourly", (event) => {
+    handlers.onBucketClosed("hourly", JSON.parse((event as MessageEvent).data));
+  });
+  source.addEventListener("daily", (event) => {
+    handlers.onBucketClosed("daily", JSON.parse((event as MessageEvent).data));
+  });
+
+  return () => source.close();
 };
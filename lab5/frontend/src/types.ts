@@ -9,6 +9,27 @@ export type TemperatureResponse = {
 };
 
 export type CurrentTemperature = {
+  sensor: number;
   temperature: number;
   timestamp: number;
 };
+
+export type ClosedBucket = {
+  sensor: number;
+  timestamp: number;
+  temperature: number;
+  count: number;
+};
+
+export type SensorSummary = {
+  sensor: number;
+  timestamp: number;
+  temperature: number;
+  hourly: ClosedBucket;
+  daily: ClosedBucket;
+};
+
+export type TemperatureStreamHandlers = {
+  onReading: (reading: CurrentTemperature) => void;
+  onBucketClosed: (type: "hourly" | "daily", bucket: ClosedBucket) => void;
+};
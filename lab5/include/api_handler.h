@@ -1,22 +1,72 @@
 #pragma once
 
 #include "db_manager.h"
+#include "downsampler.h"
+#include "event_broadcaster.h"
+#include "response_cache.h"
 #include <boost/beast/http.hpp>
+#include <functional>
 #include <memory>
 #include <string>
 
 namespace http = boost::beast::http;
 
+// Produces a response body piece by piece: appends the next piece to out and
+// returns false once the body is complete. Throws if the body cannot be
+// finished; by then the headers are gone, so the connection is dropped.
+using ChunkSource = std::function<bool(std::string& out)>;
+
+enum class HistoryFormat {
+    Json,     // {"data":[{"timestamp":..,"temperature":..},...]}
+    Columnar  // see below
+};
+
+// Columnar history (application/octet-stream), little-endian:
+//   "TMPC"                      magic
+//   block*                      one per database page
+//   varint 0                    end of data
+// block:
+//   varint count                number of readings, > 0
+//   count x zigzag varint       timestamp minus the previous one (the first
+//                               reading of the response is relative to 0)
+//   count x float32             temperatures
+constexpr char COLUMNAR_MAGIC[4] = {'T', 'M', 'P', 'C'};
+
+struct HistoryQuery {
+    int sensor = 0;
+    std::string type;
+    time_t start = 0;
+    time_t end = 0;
+    HistoryFormat format = HistoryFormat::Json;
+    size_t points = 0; // 0 returns every reading, otherwise MIN_DOWNSAMPLE_POINTS..MAX_DOWNSAMPLE_POINTS
+    DownsampleMethod method = DownsampleMethod::Lttb;
+};
+
 class ApiHandler {
 public:
     explicit ApiHandler(std::shared_ptr<DbManager> dbManager);
 
-    http::response<http::string_body> handleCurrentTemperature();
-    http::response<http::string_body> handleTemperatureHistory(const std::string& type, 
-                                                             const std::string& start,
-                                                             const std::string& end);
+    http::response<http::string_body> handleCurrentTemperature(int sensor);
+    // Latest reading and open hourly/daily averages of every sensor.
+    http::response<http::string_body> handleSensors();
+    // Streams the history one database page at a time, so memory use does
+    // not depend on the size of the range. With query.points set, the pages
+    // pass through a Downsampler on the way; LTTB first sums up the range's
+    // buckets in one aggregate query. Errors reading the first page
+    // are thrown before anything is sent.
+    // Responses that fit in the cache are copied into it as they stream.
+    ChunkSource streamTemperatureHistory(const HistoryQuery& query);
+    // A complete earlier response to the same query, or nullptr.
+    std::shared_ptr<const ResponseCache::Entry> cachedTemperatureHistory(const HistoryQuery& query);
+    static const char* contentType(HistoryFormat format);
+    static http::response<http::string_body> errorResponse(http::status status, const std::string& message);
+
+    // Ingest callbacks that publish readings and closed buckets as JSON
+    // events, each on the channel of its sensor.
+    static IngestEvents streamEvents(std::shared_ptr<EventBroadcaster> broadcaster);
     
 private:
     std::string getFormattedTime(time_t timestamp);
     std::shared_ptr<DbManager> db_manager_;
+    std::shared_ptr<ResponseCache> history_cache_;
 }; 
\ No newline at end of file
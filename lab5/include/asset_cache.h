@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Contents of the static doc_root, read once at startup and never changed.
+// Every file is kept with its Content-Type, a strong ETag and, for text
+// types, gzip and brotli variants. "<file>.gz" / "<file>.br" produced by the
+// frontend build are used as-is; otherwise the variants are compressed here
+// (brotli only when built with HAVE_BROTLI). Restart to pick up new files.
+class AssetCache {
+public:
+    enum class Encoding { Identity, Gzip, Brotli };
+
+    struct Asset {
+        std::string content_type;
+        std::string cache_control;
+        std::string etag;
+        std::shared_ptr<const std::string> identity;
+        std::shared_ptr<const std::string> gzip;
+        std::shared_ptr<const std::string> brotli;
+    };
+
+    struct Variant {
+        Encoding encoding;
+        std::shared_ptr<const std::string> body;
+        std::string etag;
+    };
+
+    explicit AssetCache(const std::string& doc_root);
+
+    // Looks up a request path ("/" means "/index.html"); nullptr if unknown.
+    const Asset* find(std::string_view target) const;
+
+    size_t size() const { return assets_.size(); }
+    size_t bytes() const { return bytes_; }
+
+    // Smallest variant that the Accept-Encoding header allows.
+    static Variant select(const Asset& asset, std::string_view accept_encoding);
+    // True if the If-None-Match header names any variant of the asset.
+    static bool matches(const Asset& asset, std::string_view if_none_match);
+    static const char* encodingName(Encoding encoding);
+
+private:
+    std::unordered_map<std::string, Asset> assets_;
+    size_t bytes_;
+};
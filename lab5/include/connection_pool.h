@@ -0,0 +1,67 @@
+#pragma once
+
+#include "sqlite_statement.h"
+#include "storage_profile.h"
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <sqlite3.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Read-only connection with its own prepared statement cache.
+// Used by one thread at a time, handed out by ReadConnectionPool.
+class ReadConnection {
+public:
+    ReadConnection(const std::string& db_path, const StorageProfile& profile);
+    ~ReadConnection();
+
+    ReadConnection(const ReadConnection&) = delete;
+    ReadConnection& operator=(const ReadConnection&) = delete;
+
+    sqlite3* handle() const { return db_; }
+    // Prepares sql on first use and returns the cached statement afterwards.
+    SqliteStatement& statement(const std::string& sql);
+
+private:
+    sqlite3* db_;
+    std::unordered_map<std::string, SqliteStatement> statements_;
+};
+
+class ReadConnectionPool {
+public:
+    // Returns its connection to the pool when destroyed.
+    class Lease {
+    public:
+        Lease(ReadConnectionPool* pool, std::unique_ptr<ReadConnection> connection);
+        ~Lease();
+
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        ReadConnection* operator->() const { return connection_.get(); }
+        ReadConnection& operator*() const { return *connection_; }
+
+    private:
+        void release();
+
+        ReadConnectionPool* pool_;
+        std::unique_ptr<ReadConnection> connection_;
+    };
+
+    ReadConnectionPool(const std::string& db_path, const StorageProfile& profile, size_t size);
+
+    // Blocks until a connection is free.
+    Lease acquire();
+
+private:
+    void release(std::unique_ptr<ReadConnection> connection);
+
+    std::mutex mutex_;
+    std::condition_variable available_;
+    std::vector<std::unique_ptr<ReadConnection>> idle_;
+};
@@ -3,25 +3,141 @@
 #include <string>
 #include <vector>
 #include <ctime>
+#include <functional>
+#include <map>
 #include <sqlite3.h>
 #include <memory>
+#include <mutex>
+#include "connection_pool.h"
+#include "downsampler.h"
+#include "latest_reading.h"
+#include "sqlite_statement.h"
+#include "storage_profile.h"
+#include "temperature_record.h"
+#include "wal_checkpointer.h"
 
-struct TemperatureRecord {
-    time_t timestamp;
-    double temperature;
+// Hourly or daily bucket that is still receiving readings.
+struct RollupBucket {
+    time_t start = 0;
+    double sum = 0.0;
+    sqlite3_int64 count = 0;
+
+    double average() const { return count > 0 ? sum / count : 0.0; }
+};
+
+// In-memory state of one sensor, restored at startup and kept current by
+// the ingest path.
+struct WarmState {
+    bool has_latest = false;
+    TemperatureRecord latest{0, 0.0};
+    RollupBucket hour;
+    RollupBucket day;
 };
 
+// Callbacks run by the ingest path after each committed batch, on the
+// ingesting thread and with the writer lock held, so they must be quick.
+struct IngestEvents {
+    std::function<void(const TemperatureRecord&)> onReading;
+    // A bucket is closed once a reading of the same sensor for a later
+    // bucket has been stored.
+    std::function<void(int sensor, const std::string& type, const RollupBucket&)> onBucketClosed;
+    // Rows of this sensor and type with timestamps in [from, to] may have changed.
+    std::function<void(int sensor, const std::string& type, time_t from, time_t to)> onRangeChanged;
+};
+
+// Owns one writer connection, used by the ingest path and guarded by a mutex,
+// and a pool of read-only connections for concurrent queries.
+// Every row belongs to a sensor (0 <= sensor < MAX_SENSORS), and rollups
+// and warm state are kept per sensor.
 class DbManager {
 public:
-    explicit DbManager(const std::string& dbPath);
+    explicit DbManager(const std::string& dbPath, const StorageProfile& profile = StorageProfile());
     ~DbManager();
 
+    // Brings the schema up to date without touching existing rows.
     void createTables();
-    void insertTemperature(time_t timestamp, double temperature, const std::string& type);
-    double getCurrentTemperature();
-    std::vector<TemperatureRecord> getTemperatures(const std::string& type, time_t start, time_t end);
+    // Loads the latest reading and the open hourly/daily buckets of every
+    // sensor into memory.
+    void warmStart();
+    // Sensors that have stored at least one reading, by id.
+    std::map<int, WarmState> warmState() const;
+    // Every registered set of callbacks is run, in registration order.
+    void addIngestEvents(IngestEvents events);
+    void insertTemperature(int sensor, time_t timestamp, double temperature, const std::string& type);
+    // Inserts raw readings, of any mix of sensors, and folds them into their
+    // hourly/daily rollups in one transaction.
+    void insertTemperatures(const std::vector<TemperatureRecord>& records);
+    // Lock-free; returns false if the sensor has no reading stored yet.
+    bool getLatestReading(int sensor, TemperatureRecord& record) const;
+    std::vector<TemperatureRecord> getTemperatures(int sensor, const std::string& type, time_t start, time_t end);
+    // Appends at most limit (0 = all) records with start <= timestamp <= end,
+    // oldest first, and returns how many were read. Large ranges are read
+    // page by page, continuing from the last timestamp + 1, so no connection
+    // is held between pages.
+    size_t readTemperatures(int sensor, const std::string& type, time_t start, time_t end,
+                            size_t limit, std::vector<TemperatureRecord>& out);
+    // Appends a summary of every non-empty bucket when [start, end] is cut
+    // into `buckets` equal time buckets as a Downsampler cuts it, in bucket
+    // order. One aggregate query, so only the summaries are held in memory.
+    void summarizeBuckets(int sensor, const std::string& type, time_t start, time_t end,
+                          long long buckets, std::vector<BucketSummary>& out);
 
 private:
+    struct RollupDelta {
+        double sum = 0.0;
+        sqlite3_int64 count = 0;
+    };
+    // (sensor, bucket start), so each sensor's buckets are adjacent and in order.
+    using RollupKey = std::pair<int, time_t>;
+    using RollupDeltas = std::map<RollupKey, RollupDelta>;
+
+    struct ClosedBucket {
+        int sensor;
+        const char* type;
+        RollupBucket bucket;
+    };
+
+    void execute(const std::string& sql);
+    void applyProfile();
+    int schemaVersion();
+    bool hasColumn(const std::string& table, const std::string& column);
+    void migrate(int version, void (DbManager::*step)());
+    void migrateToV1();
+    void migrateToV2();
+    void migrateToV3();
+    std::vector<int> storedSensors();
+    bool loadBucket(int sensor, const std::string& type, RollupBucket& bucket);
+    void prepareStatements();
+    void insertRow(int sensor, time_t timestamp, double temperature, const std::string& type);
+    void updateRollup(const std::string& type, const RollupKey& key, const RollupDelta& delta);
+    // Returns the buckets that the batch moved past, for onBucketClosed.
+    std::vector<ClosedBucket> applyToWarmState(const RollupDeltas& hours, const RollupDeltas& days);
+    void publishLatest(const TemperatureRecord& record);
+    void notifyRangeChanged(int sensor, const std::string& type, time_t from, time_t to);
+    // Calls notifyRangeChanged once per sensor, with the first and last bucket.
+    void notifyRollupsChanged(const std::string& type, const RollupDeltas& deltas);
+
     sqlite3* db;
     std::string dbPath;
+    StorageProfile profile;
+    std::unique_ptr<WalCheckpointer> checkpointer;
+
+    // Compiled once per connection by prepareStatements().
+    SqliteStatement beginStmt;
+    SqliteStatement commitStmt;
+    SqliteStatement rollbackStmt;
+    SqliteStatement insertStmt;
+    SqliteStatement insertRawStmt;
+    SqliteStatement rollupStmt;
+    SqliteStatement currentStmt;
+    SqliteStatement bucketStmt;
+    std::mutex writeMutex;
+    std::vector<IngestEvents> ingestListeners;
+
+    std::unique_ptr<ReadConnectionPool> readPool;
+
+    // warm[sensor].latest is not kept up to date; latestReadings is the live copy.
+    mutable std::mutex warmMutex;
+    std::map<int, WarmState> warm;
+    std::unique_ptr<LatestReading[]> latestReadings; // MAX_SENSORS cells
 }; 
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "temperature_record.h"
+
+enum class DownsampleMethod {
+    Lttb,    // Largest-Triangle-Three-Buckets: keeps the visual shape
+    MinMax,  // lowest and highest reading of each bucket
+    Average  // mean of each bucket
+};
+
+// Accepts "lttb", "minmax" and "avg"; throws std::invalid_argument otherwise.
+DownsampleMethod parseDownsampleMethod(std::string_view name);
+
+// Bounds of the `points` a history query may ask for. Below 3 LTTB has no
+// room between the first and the last reading; the upper bound keeps the
+// per-bucket state of a query small.
+constexpr size_t MIN_DOWNSAMPLE_POINTS = 3;
+constexpr size_t MAX_DOWNSAMPLE_POINTS = 100000;
+
+// Readings of one bucket of a range, summed before the range is streamed.
+struct BucketSummary {
+    long long bucket = 0;
+    size_t count = 0;
+    double timestamp_sum = 0.0;
+    double temperature_sum = 0.0;
+    TemperatureRecord last{0, 0.0};  // latest reading of the bucket
+};
+
+// Reduces readings in [start, end], fed in timestamp order, to at most
+// `points` representative ones in a single pass. The range is cut into
+// equal time buckets, so gaps in the data stay gaps. No method buffers
+// readings: LTTB keeps only the best candidate of the current bucket, and
+// takes the next bucket's average from summaries made before the pass.
+class Downsampler {
+public:
+    // Throws std::invalid_argument if points is outside
+    // [MIN_DOWNSAMPLE_POINTS, MAX_DOWNSAMPLE_POINTS].
+    Downsampler(DownsampleMethod method, size_t points, time_t start, time_t end);
+
+    // Reading t falls in bucket floor((t - start) * buckets() / (end - start + 1)).
+    long long buckets() const { return buckets_; }
+    // LTTB needs the summary of every non-empty bucket, in bucket order,
+    // before the first add(). Summaries that no longer match the readings
+    // (rows added in between) only make the choice of points less exact.
+    bool needsSummaries() const { return method_ == DownsampleMethod::Lttb; }
+    void setSummaries(std::vector<BucketSummary> summaries);
+
+    // Appends to out any points completed by this reading.
+    void add(const TemperatureRecord& record, std::vector<TemperatureRecord>& out);
+    // Appends the remaining points; call once after the last reading.
+    void finish(std::vector<TemperatureRecord>& out);
+
+private:
+    struct Summary {
+        size_t count = 0;
+        double timestamp_sum = 0.0;
+        double temperature_sum = 0.0;
+        TemperatureRecord min{0, 0.0};
+        TemperatureRecord max{0, 0.0};
+    };
+
+    long long bucketOf(time_t timestamp) const;
+    void closeBucket(std::vector<TemperatureRecord>& out);
+    void considerLttb(const TemperatureRecord& record, std::vector<TemperatureRecord>& out);
+    void aimAfter(long long bucket);
+
+    DownsampleMethod method_;
+    time_t start_;
+    double span_;
+    long long buckets_;
+
+    long long current_;
+    Summary summary_;
+
+    // LTTB: the first and last readings are always kept; the rest are chosen
+    // per bucket against the previously chosen point (anchor_) and the
+    // average of the next non-empty bucket (target_). The latest reading is
+    // held back in pending_ until another arrives, since the last one does
+    // not compete in its bucket.
+    size_t seen_;
+    TemperatureRecord anchor_;
+    TemperatureRecord pending_;
+    TemperatureRecord best_;
+    double best_area_;
+    double target_timestamp_;
+    double target_temperature_;
+    std::vector<BucketSummary> summaries_;
+    size_t next_summary_;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+// Fans server-sent events out to every open event stream. An event is
+// formatted once and the same buffer is handed to all subscribers.
+// Events are published on a channel (the sensor id) and a subscriber gets
+// either one channel or all of them. The latest event of each name on each
+// channel is kept and replayed to new subscribers, so a client that
+// connects between readings still gets the current one.
+class EventBroadcaster {
+public:
+    using Message = std::shared_ptr<const std::string>;
+    // Called with the broadcaster's mutex held; must not block.
+    using Subscriber = std::function<void(const Message&)>;
+
+    static constexpr int all_channels = -1;
+
+    uint64_t subscribe(Subscriber subscriber, int channel = all_channels);
+    void unsubscribe(uint64_t id);
+    void publish(const std::string& event, const std::string& data, int channel = 0);
+
+private:
+    struct Subscription {
+        int channel;
+        Subscriber deliver;
+    };
+
+    std::mutex mutex_;
+    uint64_t next_id_ = 1;
+    std::map<uint64_t, Subscription> subscribers_;
+    std::map<std::pair<int, std::string>, Message> latest_;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include "event_broadcaster.h"
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+using tcp = boost::asio::ip::tcp;
+
+// A text/event-stream response that stays open and receives every event
+// published on one channel of the broadcaster, or on all of them.
+// Takes over the connection from HttpSession.
+// A client that falls behind loses its oldest queued events rather than
+// growing the queue without bound.
+class EventStream : public std::enable_shared_from_this<EventStream> {
+public:
+    static constexpr size_t max_queued = 64;
+    static constexpr std::chrono::seconds write_timeout{30};
+
+    EventStream(beast::tcp_stream&& stream, std::shared_ptr<EventBroadcaster> broadcaster,
+                int channel = EventBroadcaster::all_channels);
+    void start(unsigned version);
+
+private:
+    void enqueue(EventBroadcaster::Message message);
+    void do_write();
+    void on_write(beast::error_code ec, std::size_t bytes_transferred);
+    void do_read();
+    void close();
+
+    beast::tcp_stream stream_;
+    std::shared_ptr<EventBroadcaster> broadcaster_;
+    int channel_;
+    uint64_t subscription_;
+    std::deque<EventBroadcaster::Message> queue_;
+    bool writing_;
+    bool closed_;
+    std::array<char, 512> discard_;
+};
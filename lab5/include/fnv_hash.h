@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+// FNV-1a, used for the ETags of static files. It is fast but only 64 bits
+// wide: if a file changes and its new content has the same hash and size, a
+// client holding the old tag gets a 304 and keeps the old content. Static
+// files only change with a restart, so that chance (about 2^-64 per change)
+// is accepted there; cached history responses, which change all the time,
+// get tags that name the cache entry instead.
+inline uint64_t fnv1a64(std::string_view data) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Unquoted "<hash>-<size>".
+inline std::string contentTag(std::string_view data) {
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(fnv1a64(data)));
+    return std::string(buffer) + "-" + std::to_string(data.size());
+}
@@ -6,7 +6,11 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <string>
 #include <memory>
+#include <thread>
+#include <vector>
 #include "api_handler.h"
+#include "asset_cache.h"
+#include "event_broadcaster.h"
 
 namespace beast = boost::beast;
 namespace http = beast::http;
@@ -14,18 +18,26 @@ using tcp = boost::asio::ip::tcp;
 
 class HttpServer {
 public:
+    // threads == 0 uses one worker per hardware thread.
     HttpServer(const std::string& address, unsigned short port, 
-              const std::string& doc_root, std::shared_ptr<DbManager> db_manager);
+              const std::string& doc_root, std::shared_ptr<DbManager> db_manager,
+              std::shared_ptr<EventBroadcaster> events, size_t threads = 0);
     
+    // Runs the io_context on all worker threads; returns after stop().
     void start();
     void stop();
 
 private:
-    void do_accept(tcp::acceptor& acceptor);
+    // Runs the io_context on the calling thread until it is stopped.
+    void run();
+    void do_accept();
     
+    size_t threads_;
     boost::asio::io_context io_context_;
+    tcp::acceptor acceptor_;
     std::string address_;
     unsigned short port_;
-    std::string doc_root_;
+    std::shared_ptr<const AssetCache> assets_;
     std::shared_ptr<ApiHandler> api_handler_;
+    std::shared_ptr<EventBroadcaster> events_;
 }; 
\ No newline at end of file
@@ -4,26 +4,62 @@
 #include <boost/beast/http.hpp>
 #include <boost/beast/version.hpp>
 #include <boost/asio/ip/tcp.hpp>
-#include <boost/filesystem.hpp>
+#include <chrono>
 #include <memory>
 #include <string>
+#include <string_view>
 #include "api_handler.h"
+#include "asset_cache.h"
+#include "event_broadcaster.h"
+#include "query_string.h"
 
 namespace beast = boost::beast;
 namespace http = beast::http;
-namespace fs = boost::filesystem;
 using tcp = boost::asio::ip::tcp;
 
+// One HTTP/1.1 connection. Requests are served in order on the same
+// connection until the client closes it, it stays idle for idle_timeout,
+// or max_requests have been answered. idle_timeout only covers waiting for
+// a request; sending a response gets its own write_timeout.
 class HttpSession : public std::enable_shared_from_this<HttpSession> {
 public:
-    HttpSession(tcp::socket&& socket, std::string doc_root, std::shared_ptr<ApiHandler> api_handler);
+    static constexpr std::chrono::seconds idle_timeout{30};
+    static constexpr std::chrono::seconds write_timeout{30};
+    static constexpr unsigned max_requests = 1000;
+
+    HttpSession(tcp::socket&& socket, std::shared_ptr<const AssetCache> assets, std::shared_ptr<ApiHandler> api_handler,
+                std::shared_ptr<EventBroadcaster> events);
     void start();
 
 private:
+    struct ChunkedWrite;
+
+    // API endpoints, matched on the exact path with the query stripped.
+    struct Route {
+        std::string_view path;
+        void (HttpSession::*handler)(const QueryString& query);
+    };
+    static const Route routes[];
+
+    void do_read();
+    void on_read(beast::error_code ec, std::size_t bytes_transferred);
+    void on_write(bool close, beast::error_code ec, std::size_t bytes_transferred);
+    void do_close();
+    void write_chunk(std::shared_ptr<ChunkedWrite> write);
+    bool keep_alive() const;
     void handle_request();
     bool handle_api_request();
-    void send_file(const std::string& path);
+    // Reads ?sensor=N (default 0); sends a 400 and returns false if it is invalid.
+    bool parse_sensor(const QueryString& query, int& sensor);
+    void handle_current(const QueryString& query);
+    void handle_sensors(const QueryString& query);
+    void handle_history(const QueryString& query);
+    void handle_stream(const QueryString& query);
+    void send_asset(const AssetCache::Asset& asset);
+    void send_cached(std::shared_ptr<const ResponseCache::Entry> entry);
     void send_response(http::response<http::string_body>&& msg);
+    // Sends a Transfer-Encoding: chunked response whose body comes from source.
+    void send_chunked(http::response<http::buffer_body>&& header, ChunkSource source);
     
     template<typename Body>
     void add_cors_headers(http::response<Body>& res) {
@@ -32,9 +68,11 @@ private:
         res.set(http::field::access_control_allow_headers, "Content-Type");
     }
 
-    tcp::socket socket_;
+    beast::tcp_stream stream_;
     beast::flat_buffer buffer_;
     http::request<http::string_body> request_;
-    std::string doc_root_;
+    unsigned requests_served_;
+    std::shared_ptr<const AssetCache> assets_;
     std::shared_ptr<ApiHandler> api_handler_;
+    std::shared_ptr<EventBroadcaster> events_;
 }; 
\ No newline at end of file
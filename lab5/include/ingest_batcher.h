@@ -0,0 +1,31 @@
+#pragma once
+
+#include "db_manager.h"
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <memory>
+#include <vector>
+
+// Collects raw readings and writes them to the database in one transaction
+// once the batch is full or its oldest reading has waited max_delay.
+class IngestBatcher {
+public:
+    IngestBatcher(std::shared_ptr<DbManager> db_manager,
+                  size_t max_batch_size,
+                  std::chrono::milliseconds max_delay);
+    ~IngestBatcher();
+
+    void add(int sensor, time_t timestamp, double temperature);
+    void flushIfDue();
+    void flush();
+
+    size_t pending() const { return pending_.size(); }
+
+private:
+    std::shared_ptr<DbManager> db_manager_;
+    size_t max_batch_size_;
+    std::chrono::milliseconds max_delay_;
+    std::vector<TemperatureRecord> pending_;
+    std::chrono::steady_clock::time_point oldest_;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "db_manager.h"
+#include "spsc_queue.h"
+#include "temperature_record.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Moves readings from the serial reader to the database on a thread of its
+// own, so a slow commit (fsync, a checkpoint, a busy lock) never keeps the
+// reader away from the ports. Readings pass through a lock-free SPSC ring;
+// the writer thread drains it into an IngestBatcher.
+//
+// Backpressure: add() never waits. When the ring is full the reading is
+// dropped and counted, so a stuck disk can cost readings but never keeps
+// the reader from its ports; the ring is sized to ride out a slow commit.
+class IngestWriter {
+public:
+    struct Stats {
+        uint64_t queued = 0;       // accepted by add()
+        uint64_t written = 0;      // committed to the database
+        uint64_t backpressure = 0; // times the ring filled up
+        uint64_t dropped = 0;      // readings lost because the ring was full
+        size_t high_water = 0;     // most readings waiting in the ring at once
+    };
+
+    IngestWriter(std::shared_ptr<DbManager> db_manager,
+                 size_t capacity,
+                 size_t max_batch_size,
+                 std::chrono::milliseconds max_delay);
+    // Calls stop().
+    ~IngestWriter();
+
+    IngestWriter(const IngestWriter&) = delete;
+    IngestWriter& operator=(const IngestWriter&) = delete;
+
+    // Reader thread only. Returns false if the reading was dropped.
+    bool add(int sensor, time_t timestamp, double temperature);
+    // Writes everything still queued and joins the writer thread.
+    void stop();
+
+    Stats stats() const;
+
+private:
+    // How often an idle writer looks at the ring. Readings wait for the
+    // batch delay anyway, so the reader never has to wake the writer.
+    static constexpr std::chrono::milliseconds poll_interval{20};
+
+    void run(size_t max_batch_size, std::chrono::milliseconds max_delay);
+
+    std::shared_ptr<DbManager> db_manager_;
+    SpscQueue<TemperatureRecord> queue_;
+    bool overflowing_;
+
+    std::atomic<uint64_t> queued_{0};
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> backpressure_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<size_t> high_water_{0};
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    bool stopping_;
+    std::thread thread_;
+};
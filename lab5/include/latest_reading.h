@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include "temperature_record.h"
+
+// Single-writer, many-reader cell holding the most recent reading.
+// It is a seqlock: the writer makes the sequence odd while it updates the
+// fields, and readers retry until they see the same even sequence before and
+// after copying them. Readers never block and never touch the database.
+// Writers must be serialized by the caller (DbManager holds writeMutex).
+class LatestReading {
+public:
+    void publish(const TemperatureRecord& record) {
+        uint64_t seq = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        timestamp_.store(static_cast<int64_t>(record.timestamp), std::memory_order_relaxed);
+        temperature_.store(record.temperature, std::memory_order_relaxed);
+
+        sequence_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Returns false until the first reading has been published.
+    bool load(TemperatureRecord& record) const {
+        for (;;) {
+            uint64_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+
+            int64_t timestamp = timestamp_.load(std::memory_order_relaxed);
+            double temperature = temperature_.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                if (before == 0) {
+                    return false;
+                }
+                record.timestamp = static_cast<time_t>(timestamp);
+                record.temperature = temperature;
+                return true;
+            }
+        }
+    }
+
+private:
+    std::atomic<uint64_t> sequence_{0};
+    std::atomic<int64_t> timestamp_{0};
+    std::atomic<double> temperature_{0.0};
+};
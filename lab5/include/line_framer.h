@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Fixed-size ring buffer that turns a byte stream into newline-terminated
+// records. Bytes are read straight into the free space (writePtr/commit),
+// so nothing is copied until a complete line is taken out. A line longer
+// than the buffer is dropped up to its newline and counted.
+class LineFramer {
+public:
+    explicit LineFramer(size_t capacity = 4096);
+
+    // Contiguous free space at the write position; may be less than the
+    // total free space when it wraps around the end of the buffer.
+    char* writePtr();
+    size_t writable() const;
+    void commit(size_t count);
+
+    // Takes the next complete line out of the buffer, without "\n" or "\r\n".
+    bool nextLine(std::string& line);
+
+    size_t buffered() const { return static_cast<size_t>(tail_ - head_); }
+    uint64_t droppedLines() const { return dropped_; }
+
+private:
+    std::vector<char> buffer_;
+    uint64_t head_;  // first unread byte
+    uint64_t scan_;  // bytes before this are known to hold no newline
+    uint64_t tail_;  // one past the last written byte
+    bool discarding_;
+    uint64_t dropped_;
+};
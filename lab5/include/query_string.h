@@ -0,0 +1,34 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <utility>
+
+// Read-only view over the query part of a request target ("a=1&b=x%20y").
+// Lookups scan the original string and decode into a buffer owned by the
+// caller, so nothing is allocated. Decoding follows the URL standard:
+// "+" is a space, "%XX" is a byte, and malformed escapes are kept as-is.
+class QueryString {
+public:
+    using Buffer = std::array<char, 256>;
+
+    QueryString() = default;
+    explicit QueryString(std::string_view query) : query_(query) {}
+
+    // Splits "/path?query#fragment" into the path and the query.
+    static std::pair<std::string_view, QueryString> splitTarget(std::string_view target);
+
+    // Decoded value of the first parameter named key. Returns false if there
+    // is none or the decoded value does not fit in the buffer.
+    bool get(std::string_view key, Buffer& buffer, std::string_view& value) const;
+    // Whether a parameter named key is present, whatever its value; tells a
+    // missing parameter from one get() could not decode.
+    bool has(std::string_view key) const;
+
+private:
+    // Still encoded value of the first parameter named key.
+    bool find(std::string_view key, std::string_view& encoded) const;
+
+    std::string_view query_;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Complete, serialized history responses, kept in least-recently-used order
+// and bounded by entry count and total bytes. An entry covers the rows of
+// one sensor and type in [start, end] and is dropped as soon as the ingest
+// path writes inside that range, so entries for ranges in the past live
+// until evicted.
+class ResponseCache {
+public:
+    struct Entry {
+        int sensor;
+        std::string type;
+        time_t start;
+        time_t end;
+        std::string content_type;
+        // Quoted "<instance>-<sequence>": unique to this entry, and random per
+        // process, so a tag from before a restart never matches.
+        std::string etag;
+        std::shared_ptr<const std::string> body;
+    };
+
+    ResponseCache(size_t max_entries, size_t max_bytes, size_t max_entry_bytes);
+
+    std::shared_ptr<const Entry> find(const std::string& key);
+
+    // Bumped by every invalidation. A response read from the database is
+    // not stored if an invalidation since the generation taken before the
+    // read overlaps its range, so a write that raced with the read cannot
+    // leave a stale entry behind, while writes elsewhere (such as live
+    // readings of the same sensor) do not keep the cache from filling.
+    uint64_t generation() const;
+    void insert(const std::string& key, Entry entry, uint64_t generation);
+    void invalidate(int sensor, const std::string& type, time_t from, time_t to);
+
+    size_t maxEntryBytes() const { return max_entry_bytes_; }
+
+private:
+    using Item = std::pair<std::string, std::shared_ptr<const Entry>>;
+
+    struct Change {
+        uint64_t generation;
+        int sensor;
+        std::string type;
+        time_t from;
+        time_t to;
+    };
+
+    bool changedSince(const Entry& entry, uint64_t generation) const;
+    void evict();
+
+    size_t max_entries_;
+    size_t max_bytes_;
+    size_t max_entry_bytes_;
+
+    mutable std::mutex mutex_;
+    uint64_t generation_;
+    // The latest invalidations, oldest first. A read older than all of them
+    // is not stored, since what changed during it is no longer known.
+    std::deque<Change> changes_;
+    std::string instance_;
+    uint64_t inserted_;
+    size_t bytes_;
+    std::list<Item> order_; // most recently used first
+    std::unordered_map<std::string, std::list<Item>::iterator> index_;
+};
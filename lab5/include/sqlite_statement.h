@@ -0,0 +1,49 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <string>
+
+// Owns a prepared statement for the lifetime of its connection.
+// The statement is compiled once and reused: bind, step, then reset.
+class SqliteStatement {
+public:
+    SqliteStatement();
+    SqliteStatement(sqlite3* db, const char* sql);
+    ~SqliteStatement();
+
+    SqliteStatement(SqliteStatement&& other) noexcept;
+    SqliteStatement& operator=(SqliteStatement&& other) noexcept;
+    SqliteStatement(const SqliteStatement&) = delete;
+    SqliteStatement& operator=(const SqliteStatement&) = delete;
+
+    explicit operator bool() const { return stmt_ != nullptr; }
+    sqlite3_stmt* get() const { return stmt_; }
+
+    void bind(int index, sqlite3_int64 value);
+    void bind(int index, double value);
+    // The text must outlive the next reset().
+    void bind(int index, const std::string& value);
+
+    // Returns true while a row is available; throws on errors.
+    bool step();
+    // Steps a statement that produces no rows.
+    void exec();
+    void reset();
+
+private:
+    sqlite3_stmt* stmt_;
+};
+
+// Resets a cached statement when leaving scope, including by exception,
+// so a failed call never leaves it half-stepped or holding old bindings.
+class StatementScope {
+public:
+    explicit StatementScope(SqliteStatement& stmt) : stmt_(stmt) {}
+    ~StatementScope() { stmt_.reset(); }
+
+    StatementScope(const StatementScope&) = delete;
+    StatementScope& operator=(const StatementScope&) = delete;
+
+private:
+    SqliteStatement& stmt_;
+};
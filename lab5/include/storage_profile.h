@@ -0,0 +1,30 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <sqlite3.h>
+#include <string>
+
+// How much of a recent commit may be lost on power failure.
+enum class Durability {
+    Full,   // synchronous=FULL: every commit is on disk before it returns
+    Normal, // synchronous=NORMAL: in WAL mode only the last commits can be lost, never corrupted
+    Off     // synchronous=OFF: no fsync at all, fastest
+};
+
+// SQLite tuning applied to every connection DbManager opens.
+struct StorageProfile {
+    Durability durability = Durability::Normal;
+    // WAL lets readers run alongside the ingest writer.
+    bool wal = true;
+    int cache_size_kib = 16 * 1024;
+    sqlite3_int64 mmap_size = 256LL * 1024 * 1024;
+    int busy_timeout_ms = 5000;
+    // Read-only connections shared by HTTP handlers; the writer has its own.
+    size_t read_connections = 4;
+    // Background passive checkpoint period; zero leaves checkpoints to SQLite.
+    std::chrono::seconds checkpoint_interval{30};
+};
+
+bool parseDurability(const std::string& name, Durability& durability);
+const char* durabilityName(Durability durability);
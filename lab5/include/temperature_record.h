@@ -0,0 +1,13 @@
+#pragma once
+
+#include <ctime>
+
+// Sensors are numbered from 0 in the order their ports are given to the
+// monitor; ids are kept below this so per-sensor state can live in arrays.
+constexpr int MAX_SENSORS = 256;
+
+struct TemperatureRecord {
+    time_t timestamp;
+    double temperature;
+    int sensor = 0;
+};
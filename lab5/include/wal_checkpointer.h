@@ -0,0 +1,30 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Runs passive WAL checkpoints on its own connection at a fixed interval,
+// so the ingest writer never stalls on copying the WAL into the database.
+class WalCheckpointer {
+public:
+    WalCheckpointer(const std::string& db_path, std::chrono::seconds interval, int busy_timeout_ms);
+    ~WalCheckpointer();
+
+    WalCheckpointer(const WalCheckpointer&) = delete;
+    WalCheckpointer& operator=(const WalCheckpointer&) = delete;
+
+private:
+    void run();
+
+    std::string db_path_;
+    std::chrono::seconds interval_;
+    int busy_timeout_ms_;
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    bool stopping_;
+    std::thread thread_;
+};
@@ -1,14 +1,218 @@
 #include "api_handler.h"
 #include <boost/beast/http.hpp>
 #include <boost/json.hpp>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <sstream>
 #include <iomanip>
+#include <stdexcept>
 
 namespace http = boost::beast::http;
 namespace json = boost::json;
 
+namespace {
+
+constexpr size_t HISTORY_PAGE_SIZE = 2048;
+constexpr size_t HISTORY_CACHE_ENTRIES = 256;
+constexpr size_t HISTORY_CACHE_BYTES = 64 * 1024 * 1024;
+constexpr size_t HISTORY_CACHE_ENTRY_BYTES = 4 * 1024 * 1024;
+
+std::string historyCacheKey(const HistoryQuery& query) {
+    return std::to_string(query.sensor) + "|" + query.type + "|" + std::to_string(query.start) + "|" + std::to_string(query.end) + "|" +
+           std::to_string(static_cast<int>(query.format)) + "|" + std::to_string(query.points) + "|" +
+           std::to_string(static_cast<int>(query.method));
+}
+
+void appendInteger(std::string& out, int64_t value) {
+    char buffer[20];
+    char* end = buffer + sizeof(buffer);
+    char* p = end;
+    uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    do {
+        *--p = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) {
+        out.push_back('-');
+    }
+    out.append(p, end);
+}
+
+// Shortest representation that reads back as the same double; JSON has no
+// NaN or infinity, so those become null.
+void appendDouble(std::string& out, double value) {
+    if (!std::isfinite(value)) {
+        out.append("null");
+        return;
+    }
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+void appendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+void appendFloat32(std::string& out, double value) {
+    float f = static_cast<float>(value);
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<char>((bits >> shift) & 0xff));
+    }
+}
+
+// State of one streamed /history response. Each call to next() reads one
+// page into a reused vector and formats it, so at most one page of records
+// and one chunk of text exist at a time.
+class HistoryChunks {
+public:
+    HistoryChunks(std::shared_ptr<DbManager> db, const HistoryQuery& query)
+        : db_(std::move(db)), sensor_(query.sensor), type_(query.type), next_start_(query.start), end_(query.end)
+        , format_(query.format), written_(0), previous_(0), opened_(false), done_(false) {
+        if (query.points > 0) {
+            downsampler_ = std::make_unique<Downsampler>(query.method, query.points, query.start, query.end);
+            if (downsampler_->needsSummaries()) {
+                std::vector<BucketSummary> summaries;
+                db_->summarizeBuckets(sensor_, type_, query.start, query.end, downsampler_->buckets(), summaries);
+                downsampler_->setSummaries(std::move(summaries));
+            }
+            raw_.reserve(HISTORY_PAGE_SIZE);
+        }
+        page_.reserve(HISTORY_PAGE_SIZE);
+        readPage();
+    }
+
+    bool next(std::string& out) {
+        if (format_ == HistoryFormat::Columnar) {
+            appendColumnar(out);
+        } else {
+            appendJson(out);
+        }
+        written_ += page_.size();
+
+        if (done_) {
+            return false;
+        }
+        readPage();
+        return true;
+    }
+
+private:
+    void appendJson(std::string& out) {
+        if (!opened_) {
+            out.append("{\"data\":[");
+            opened_ = true;
+        }
+
+        for (size_t i = 0; i < page_.size(); ++i) {
+            if (written_ + i > 0) {
+                out.push_back(',');
+            }
+            out.append("{\"timestamp\":");
+            appendInteger(out, static_cast<int64_t>(page_[i].timestamp));
+            out.append(",\"temperature\":");
+            appendDouble(out, page_[i].temperature);
+            out.push_back('}');
+        }
+
+        if (done_) {
+            out.append("]}");
+        }
+    }
+
+    void appendColumnar(std::string& out) {
+        if (!opened_) {
+            out.append(COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+            opened_ = true;
+        }
+
+        if (!page_.empty()) {
+            appendVarint(out, page_.size());
+            for (const auto& record : page_) {
+                int64_t timestamp = static_cast<int64_t>(record.timestamp);
+                appendVarint(out, zigzag(timestamp - previous_));
+                previous_ = timestamp;
+            }
+            for (const auto& record : page_) {
+                appendFloat32(out, record.temperature);
+            }
+        }
+
+        if (done_) {
+            appendVarint(out, 0);
+        }
+    }
+
+    void readPage() {
+        page_.clear();
+        if (next_start_ > end_) {
+            done_ = true;
+            if (downsampler_) {
+                downsampler_->finish(page_);
+            }
+            return;
+        }
+        std::vector<TemperatureRecord>& target = downsampler_ ? raw_ : page_;
+        target.clear();
+        db_->readTemperatures(sensor_, type_, next_start_, end_, HISTORY_PAGE_SIZE, target);
+        if (target.size() < HISTORY_PAGE_SIZE) {
+            done_ = true;
+        } else {
+            next_start_ = target.back().timestamp + 1;
+        }
+
+        if (downsampler_) {
+            for (const auto& record : raw_) {
+                downsampler_->add(record, page_);
+            }
+            if (done_) {
+                downsampler_->finish(page_);
+            }
+        }
+    }
+
+    std::shared_ptr<DbManager> db_;
+    int sensor_;
+    std::string type_;
+    time_t next_start_;
+    time_t end_;
+    HistoryFormat format_;
+    std::unique_ptr<Downsampler> downsampler_;
+    std::vector<TemperatureRecord> raw_;
+    std::vector<TemperatureRecord> page_;
+    size_t written_;
+    int64_t previous_;
+    bool opened_;
+    bool done_;
+};
+
+} // namespace
+
 ApiHandler::ApiHandler(std::shared_ptr<DbManager> dbManager) 
-    : db_manager_(dbManager) {}
+    : db_manager_(dbManager)
+    , history_cache_(std::make_shared<ResponseCache>(
+          HISTORY_CACHE_ENTRIES, HISTORY_CACHE_BYTES, HISTORY_CACHE_ENTRY_BYTES)) {
+    IngestEvents events;
+    std::weak_ptr<ResponseCache> cache = history_cache_;
+    events.onRangeChanged = [cache](int sensor, const std::string& type, time_t from, time_t to) {
+        if (auto locked = cache.lock()) {
+            locked->invalidate(sensor, type, from, to);
+        }
+    };
+    db_manager_->addIngestEvents(std::move(events));
+}
 
 std::string ApiHandler::getFormattedTime(time_t timestamp) {
     std::stringstream ss;
@@ -16,16 +220,20 @@ std::string ApiHandler::getFormattedTime(time_t timestamp) {
     return ss.str();
 }
 
-http::response<http::string_body> ApiHandler::handleCurrentTemperature() {
+http::response<http::string_body> ApiHandler::handleCurrentTemperature(int sensor) {
     http::response<http::string_body> res;
     res.version(11);
     res.set(http::field::content_type, "application/json");
     
     try {
-        double temp = db_manager_->getCurrentTemperature();
+        TemperatureRecord latest;
+        if (!db_manager_->getLatestReading(sensor, latest)) {
+            throw std::runtime_error("No temperature data available");
+        }
         json::object obj;
-        obj["temperature"] = temp;
-        obj["timestamp"] = std::time(nullptr);
+        obj["sensor"] = latest.sensor;
+        obj["temperature"] = latest.temperature;
+        obj["timestamp"] = latest.timestamp;
         res.body() = json::serialize(obj);
         res.result(http::status::ok);
     } catch (const std::exception& e) {
@@ -39,38 +247,100 @@ http::response<http::string_body> ApiHandler::handleCurrentTemperature() {
     return res;
 }
 
-http::response<http::string_body> ApiHandler::handleTemperatureHistory(
-    const std::string& type, const std::string& start, const std::string& end) {
-    
-    http::response<http::string_body> res;
-    res.version(11);
-    res.set(http::field::content_type, "application/json");
-    
-    try {
-        time_t start_time = std::stoll(start);
-        time_t end_time = std::stoll(end);
-        
-        auto records = db_manager_->getTemperatures(type, start_time, end_time);
-        
-        json::array data;
-        for (const auto& record : records) {
-            json::object entry;
-            entry["timestamp"] = record.timestamp;
-            entry["temperature"] = record.temperature;
-            data.push_back(entry);
-        }
-        
+http::response<http::string_body> ApiHandler::handleSensors() {
+    auto bucketObject = [](const RollupBucket& bucket) {
         json::object obj;
-        obj["data"] = data;
-        res.body() = json::serialize(obj);
-        res.result(http::status::ok);
-    } catch (const std::exception& e) {
+        obj["timestamp"] = bucket.start;
+        obj["temperature"] = bucket.average();
+        obj["count"] = bucket.count;
+        return obj;
+    };
+
+    json::array sensors;
+    for (const auto& [sensor, state] : db_manager_->warmState()) {
+        if (!state.has_latest) {
+            continue;
+        }
         json::object obj;
-        obj["error"] = e.what();
-        res.body() = json::serialize(obj);
-        res.result(http::status::internal_server_error);
+        obj["sensor"] = sensor;
+        obj["timestamp"] = state.latest.timestamp;
+        obj["temperature"] = state.latest.temperature;
+        obj["hourly"] = bucketObject(state.hour);
+        obj["daily"] = bucketObject(state.day);
+        sensors.push_back(std::move(obj));
     }
-    
+
+    http::response<http::string_body> res{http::status::ok, 11};
+    res.set(http::field::content_type, "application/json");
+    json::object body;
+    body["sensors"] = std::move(sensors);
+    res.body() = json::serialize(body);
+    res.prepare_payload();
+    return res;
+}
+
+ChunkSource ApiHandler::streamTemperatureHistory(const HistoryQuery& query) {
+    uint64_t generation = history_cache_->generation();
+    auto chunks = std::make_shared<HistoryChunks>(db_manager_, query);
+
+    // The copy is abandoned as soon as it outgrows a cache entry.
+    auto copy = std::make_shared<std::string>();
+    return [chunks, copy, generation, query, cache = history_cache_](std::string& out) mutable {
+        size_t offset = out.size();
+        bool more = chunks->next(out);
+        if (!copy) {
+            return more;
+        }
+
+        if (copy->size() + (out.size() - offset) > cache->maxEntryBytes()) {
+            copy.reset();
+        } else {
+            copy->append(out, offset, std::string::npos);
+            if (!more) {
+                ResponseCache::Entry entry{query.sensor, query.type, query.start, query.end,
+                                           ApiHandler::contentType(query.format), "",
+                                           std::move(copy)};
+                cache->insert(historyCacheKey(query), std::move(entry), generation);
+            }
+        }
+        return more;
+    };
+}
+
+std::shared_ptr<const ResponseCache::Entry> ApiHandler::cachedTemperatureHistory(const HistoryQuery& query) {
+    return history_cache_->find(historyCacheKey(query));
+}
+
+const char* ApiHandler::contentType(HistoryFormat format) {
+    return format == HistoryFormat::Columnar ? "application/octet-stream" : "application/json";
+}
+
+http::response<http::string_body> ApiHandler::errorResponse(http::status status, const std::string& message) {
+    http::response<http::string_body> res{status, 11};
+    res.set(http::field::content_type, "application/json");
+    json::object obj;
+    obj["error"] = message;
+    res.body() = json::serialize(obj);
     res.prepare_payload();
     return res;
-} 
\ No newline at end of file
+}
+
+IngestEvents ApiHandler::streamEvents(std::shared_ptr<EventBroadcaster> broadcaster) {
+    IngestEvents events;
+    events.onReading = [broadcaster](const TemperatureRecord& record) {
+        json::object obj;
+        obj["sensor"] = record.sensor;
+        obj["timestamp"] = record.timestamp;
+        obj["temperature"] = record.temperature;
+        broadcaster->publish("reading", json::serialize(obj), record.sensor);
+    };
+    events.onBucketClosed = [broadcaster](int sensor, const std::string& type, const RollupBucket& bucket) {
+        json::object obj;
+        obj["sensor"] = sensor;
+        obj["timestamp"] = bucket.start;
+        obj["temperature"] = bucket.average();
+        obj["count"] = bucket.count;
+        broadcaster->publish(type, json::serialize(obj), sensor);
+    };
+    return events;
+}
@@ -0,0 +1,257 @@
+#include "asset_cache.h"
+#include "fnv_hash.h"
+#include <zlib.h>
+#ifdef HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+#include <cctype>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct ContentType {
+    const char* extension;
+    const char* type;
+    bool compressible;
+};
+
+const ContentType CONTENT_TYPES[] = {
+    {".html", "text/html", true},
+    {".js", "application/javascript", true},
+    {".css", "text/css", true},
+    {".json", "application/json", true},
+    {".map", "application/json", true},
+    {".txt", "text/plain", true},
+    {".svg", "image/svg+xml", true},
+    {".ico", "image/x-icon", true},
+    {".png", "image/png", false},
+    {".jpg", "image/jpeg", false},
+    {".woff2", "font/woff2", false},
+};
+
+const ContentType& contentType(const std::string& extension) {
+    static const ContentType fallback{"", "application/octet-stream", false};
+    for (const auto& entry : CONTENT_TYPES) {
+        if (extension == entry.extension) {
+            return entry;
+        }
+    }
+    return fallback;
+}
+
+std::shared_ptr<const std::string> readFile(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Failed to read asset: " + path.string());
+    }
+    return std::make_shared<const std::string>(
+        std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+std::shared_ptr<const std::string> gzipCompress(const std::string& data) {
+    z_stream zs{};
+    // windowBits + 16 asks zlib for a gzip header instead of a zlib one.
+    if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return nullptr;
+    }
+
+    std::string out(deflateBound(&zs, static_cast<uLong>(data.size())), '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+
+    int rc = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    if (rc != Z_STREAM_END) {
+        return nullptr;
+    }
+    return std::make_shared<const std::string>(std::move(out));
+}
+
+std::shared_ptr<const std::string> brotliCompress(const std::string& data) {
+#ifdef HAVE_BROTLI
+    std::string out(BrotliEncoderMaxCompressedSize(data.size()), '\0');
+    size_t out_size = out.size();
+    if (!BrotliEncoderCompress(BROTLI_MAX_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                               data.size(), reinterpret_cast<const uint8_t*>(data.data()),
+                               &out_size, reinterpret_cast<uint8_t*>(&out[0]))) {
+        return nullptr;
+    }
+    out.resize(out_size);
+    return std::make_shared<const std::string>(std::move(out));
+#else
+    (void)data;
+    return nullptr;
+#endif
+}
+
+// A variant is only worth keeping if it is actually smaller.
+std::shared_ptr<const std::string> smaller(std::shared_ptr<const std::string> variant,
+                                           const std::string& identity) {
+    return variant && variant->size() < identity.size() ? variant : nullptr;
+}
+
+std::string quoted(const std::string& tag, const char* suffix) {
+    return "\"" + tag + suffix + "\"";
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+// Calls onItem for each comma-separated element of a header value.
+template<typename F>
+void forEachListItem(std::string_view value, F onItem) {
+    while (!value.empty()) {
+        size_t comma = value.find(',');
+        onItem(trim(value.substr(0, comma)));
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        value.remove_prefix(comma + 1);
+    }
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+AssetCache::AssetCache(const std::string& doc_root)
+    : bytes_(0) {
+    fs::path root(doc_root);
+    if (!fs::exists(root)) {
+        return;
+    }
+
+    std::vector<fs::path> files;
+    for (const auto& entry : fs::recursive_directory_iterator(root)) {
+        if (entry.is_regular_file()) {
+            files.push_back(entry.path());
+        }
+    }
+
+    for (const auto& path : files) {
+        std::string extension = path.extension().string();
+        fs::path base = path;
+        base.replace_extension();
+        if ((extension == ".gz" || extension == ".br") && fs::exists(base)) {
+            continue; // picked up as a variant of base below
+        }
+
+        std::string key = "/" + fs::relative(path, root).generic_string();
+        const ContentType& type = contentType(extension);
+
+        Asset asset;
+        asset.content_type = type.type;
+        asset.cache_control = key.compare(0, 8, "/static/") == 0
+            ? "public, max-age=31536000, immutable" // file names carry a content hash
+            : "no-cache";
+        asset.identity = readFile(path);
+        asset.etag = contentTag(*asset.identity);
+
+        if (type.compressible) {
+            fs::path gz = path;
+            gz += ".gz";
+            fs::path br = path;
+            br += ".br";
+            asset.gzip = smaller(fs::exists(gz) ? readFile(gz) : gzipCompress(*asset.identity), *asset.identity);
+            asset.brotli = smaller(fs::exists(br) ? readFile(br) : brotliCompress(*asset.identity), *asset.identity);
+        }
+
+        bytes_ += asset.identity->size();
+        bytes_ += asset.gzip ? asset.gzip->size() : 0;
+        bytes_ += asset.brotli ? asset.brotli->size() : 0;
+        assets_.emplace(std::move(key), std::move(asset));
+    }
+}
+
+const AssetCache::Asset* AssetCache::find(std::string_view target) const {
+    target = target.substr(0, target.find_first_of("?#"));
+
+    std::string key(target);
+    if (key.empty() || key.back() == '/') {
+        key += "index.html";
+    }
+
+    auto it = assets_.find(key);
+    return it != assets_.end() ? &it->second : nullptr;
+}
+
+AssetCache::Variant AssetCache::select(const Asset& asset, std::string_view accept_encoding) {
+    // "*" only speaks for codings the header does not name (RFC 9110
+    // 12.5.3), so "gzip;q=0, *" still refuses gzip.
+    std::optional<bool> gzip;
+    std::optional<bool> brotli;
+    bool any = false;
+
+    forEachListItem(accept_encoding, [&](std::string_view item) {
+        std::string_view coding = trim(item.substr(0, item.find(';')));
+        bool refused = false;
+        size_t q = item.find("q=");
+        if (q != std::string_view::npos) {
+            std::string_view weight = trim(item.substr(q + 2));
+            refused = !weight.empty() && weight.find_first_not_of("0.") == std::string_view::npos;
+        }
+
+        if (equalsIgnoreCase(coding, "gzip") || equalsIgnoreCase(coding, "x-gzip")) {
+            gzip = !refused;
+        } else if (equalsIgnoreCase(coding, "br")) {
+            brotli = !refused;
+        } else if (coding == "*") {
+            any = any || !refused;
+        }
+    });
+
+    Variant best{Encoding::Identity, asset.identity, quoted(asset.etag, "")};
+    if (gzip.value_or(any) && asset.gzip && asset.gzip->size() < best.body->size()) {
+        best = {Encoding::Gzip, asset.gzip, quoted(asset.etag, "-gzip")};
+    }
+    if (brotli.value_or(any) && asset.brotli && asset.brotli->size() < best.body->size()) {
+        best = {Encoding::Brotli, asset.brotli, quoted(asset.etag, "-br")};
+    }
+    return best;
+}
+
+bool AssetCache::matches(const Asset& asset, std::string_view if_none_match) {
+    bool found = false;
+    forEachListItem(if_none_match, [&](std::string_view tag) {
+        if (tag.compare(0, 2, "W/") == 0) {
+            tag.remove_prefix(2);
+        }
+        if (tag == "*" || tag == quoted(asset.etag, "") ||
+            tag == quoted(asset.etag, "-gzip") || tag == quoted(asset.etag, "-br")) {
+            found = true;
+        }
+    });
+    return found;
+}
+
+const char* AssetCache::encodingName(Encoding encoding) {
+    switch (encoding) {
+        case Encoding::Gzip: return "gzip";
+        case Encoding::Brotli: return "br";
+        default: return "identity";
+    }
+}
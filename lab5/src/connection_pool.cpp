@@ -0,0 +1,84 @@
+#include "connection_pool.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+ReadConnection::ReadConnection(const std::string& db_path, const StorageProfile& profile) : db_(nullptr) {
+    int rc = sqlite3_open_v2(db_path.c_str(), &db_, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr);
+    if (rc != SQLITE_OK) {
+        std::string error = sqlite3_errmsg(db_);
+        sqlite3_close(db_);
+        throw std::runtime_error("Can't open read connection: " + error);
+    }
+
+    sqlite3_busy_timeout(db_, profile.busy_timeout_ms);
+
+    std::string pragmas =
+        "PRAGMA query_only = ON;"
+        "PRAGMA cache_size = -" + std::to_string(profile.cache_size_kib) + ";"
+        "PRAGMA mmap_size = " + std::to_string(profile.mmap_size) + ";";
+    sqlite3_exec(db_, pragmas.c_str(), nullptr, nullptr, nullptr);
+}
+
+ReadConnection::~ReadConnection() {
+    statements_.clear();
+    sqlite3_close(db_);
+}
+
+SqliteStatement& ReadConnection::statement(const std::string& sql) {
+    auto it = statements_.find(sql);
+    if (it == statements_.end()) {
+        it = statements_.emplace(sql, SqliteStatement(db_, sql.c_str())).first;
+    }
+    return it->second;
+}
+
+ReadConnectionPool::Lease::Lease(ReadConnectionPool* pool, std::unique_ptr<ReadConnection> connection)
+    : pool_(pool), connection_(std::move(connection)) {}
+
+ReadConnectionPool::Lease::~Lease() {
+    release();
+}
+
+ReadConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), connection_(std::move(other.connection_)) {}
+
+ReadConnectionPool::Lease& ReadConnectionPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        connection_ = std::move(other.connection_);
+    }
+    return *this;
+}
+
+void ReadConnectionPool::Lease::release() {
+    if (connection_) {
+        pool_->release(std::move(connection_));
+    }
+}
+
+ReadConnectionPool::ReadConnectionPool(const std::string& db_path, const StorageProfile& profile, size_t size) {
+    size = std::max<size_t>(size, 1);
+    idle_.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        idle_.push_back(std::make_unique<ReadConnection>(db_path, profile));
+    }
+}
+
+ReadConnectionPool::Lease ReadConnectionPool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    available_.wait(lock, [this] { return !idle_.empty(); });
+
+    auto connection = std::move(idle_.back());
+    idle_.pop_back();
+    return Lease(this, std::move(connection));
+}
+
+void ReadConnectionPool::release(std::unique_ptr<ReadConnection> connection) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_.push_back(std::move(connection));
+    }
+    available_.notify_one();
+}
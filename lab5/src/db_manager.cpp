@@ -1,24 +1,121 @@
 #include "db_manager.h"
+#include <algorithm>
 #include <stdexcept>
 #include <sstream>
+#include <map>
 
-DbManager::DbManager(const std::string& path) : dbPath(path), db(nullptr) {
+DbManager::DbManager(const std::string& path, const StorageProfile& storageProfile)
+    : dbPath(path), db(nullptr), profile(storageProfile)
+    , latestReadings(std::make_unique<LatestReading[]>(MAX_SENSORS)) {
     int rc = sqlite3_open(path.c_str(), &db);
     if (rc) {
         throw std::runtime_error("Can't open database: " + std::string(sqlite3_errmsg(db)));
     }
+
+    applyProfile();
+
+    if (profile.wal && profile.checkpoint_interval.count() > 0) {
+        checkpointer = std::make_unique<WalCheckpointer>(dbPath, profile.checkpoint_interval, profile.busy_timeout_ms);
+    }
+
+    readPool = std::make_unique<ReadConnectionPool>(dbPath, profile, profile.read_connections);
 }
 
 DbManager::~DbManager() {
+    checkpointer.reset();
     if (db) {
-        sqlite3_close(db);
+        // The cached statements are finalized after this body runs;
+        // close_v2 defers the actual close until they are.
+        sqlite3_close_v2(db);
     }
 }
 
-void DbManager::createTables() {
-    const char* sql = R"(
-        DROP TABLE IF EXISTS temperatures;
-        CREATE TABLE temperatures (
+void DbManager::execute(const std::string& sql) {
+    char* errMsg = nullptr;
+    int rc = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg);
+
+    if (rc != SQLITE_OK) {
+        std::string error = errMsg ? errMsg : sqlite3_errmsg(db);
+        sqlite3_free(errMsg);
+        throw std::runtime_error("SQL error: " + error);
+    }
+}
+
+void DbManager::applyProfile() {
+    sqlite3_busy_timeout(db, profile.busy_timeout_ms);
+
+    if (profile.wal) {
+        execute("PRAGMA journal_mode = WAL");
+        // With a background checkpointer the writer no longer checkpoints on commit.
+        if (profile.checkpoint_interval.count() > 0) {
+            execute("PRAGMA wal_autocheckpoint = 0");
+        }
+    }
+
+    switch (profile.durability) {
+        case Durability::Full: execute("PRAGMA synchronous = FULL"); break;
+        case Durability::Normal: execute("PRAGMA synchronous = NORMAL"); break;
+        case Durability::Off: execute("PRAGMA synchronous = OFF"); break;
+    }
+
+    execute("PRAGMA cache_size = -" + std::to_string(profile.cache_size_kib));
+    execute("PRAGMA mmap_size = " + std::to_string(profile.mmap_size));
+    execute("PRAGMA temp_store = MEMORY");
+}
+
+namespace {
+
+// Bump when adding a migration step below.
+constexpr int SCHEMA_VERSION = 3;
+
+const std::string RANGE_SQL =
+    "SELECT timestamp, temperature FROM temperatures "
+    "WHERE sensor_id = ? AND type = ? AND timestamp >= ? AND timestamp <= ? "
+    "ORDER BY timestamp ASC LIMIT ?";
+
+// The bucket is computed in floating point, in the same order of operations
+// as Downsampler::bucketOf. With a single max() aggregate, SQLite takes the
+// bare temperature from the row holding the latest timestamp.
+const std::string BUCKETS_SQL =
+    "SELECT CAST((timestamp - ?3) * ?5 / ?6 AS INTEGER) AS bucket, COUNT(*), "
+    "TOTAL(timestamp), TOTAL(temperature), MAX(timestamp), temperature FROM temperatures "
+    "WHERE sensor_id = ?1 AND type = ?2 AND timestamp >= ?3 AND timestamp <= ?4 "
+    "GROUP BY bucket ORDER BY bucket";
+
+} // namespace
+
+int DbManager::schemaVersion() {
+    SqliteStatement stmt(db, "PRAGMA user_version");
+    return stmt.step() ? sqlite3_column_int(stmt.get(), 0) : 0;
+}
+
+bool DbManager::hasColumn(const std::string& table, const std::string& column) {
+    SqliteStatement stmt(db, ("PRAGMA table_info(" + table + ")").c_str());
+    while (stmt.step()) {
+        const unsigned char* name = sqlite3_column_text(stmt.get(), 1);
+        if (name && column == reinterpret_cast<const char*>(name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DbManager::migrate(int version, void (DbManager::*step)()) {
+    execute("BEGIN IMMEDIATE");
+    try {
+        (this->*step)();
+        execute("PRAGMA user_version = " + std::to_string(version));
+        execute("COMMIT");
+    } catch (...) {
+        sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+        throw;
+    }
+}
+
+// v1: the original raw/hourly/daily table.
+void DbManager::migrateToV1() {
+    execute(R"(
+        CREATE TABLE IF NOT EXISTS temperatures (
             timestamp INTEGER NOT NULL,
             temperature REAL NOT NULL,
             type TEXT NOT NULL,
@@ -26,135 +123,439 @@ void DbManager::createTables() {
         );
         CREATE INDEX IF NOT EXISTS idx_temperatures_timestamp ON temperatures(timestamp);
         CREATE INDEX IF NOT EXISTS idx_temperatures_type ON temperatures(type);
-    )";
-    
-    char* errMsg = nullptr;
-    int rc = sqlite3_exec(db, sql, nullptr, nullptr, &errMsg);
-    
-    if (rc != SQLITE_OK) {
-        std::string error = errMsg;
-        sqlite3_free(errMsg);
-        throw std::runtime_error("SQL error: " + error);
+    )");
+}
+
+// v2: running sum/count on rollup rows, backfilled from the raw rows they cover.
+void DbManager::migrateToV2() {
+    if (!hasColumn("temperatures", "temperature_sum")) {
+        execute("ALTER TABLE temperatures ADD COLUMN temperature_sum REAL");
+    }
+    if (!hasColumn("temperatures", "sample_count")) {
+        execute("ALTER TABLE temperatures ADD COLUMN sample_count INTEGER");
     }
+
+    execute(R"(
+        UPDATE temperatures SET
+            temperature_sum = (SELECT SUM(raw.temperature) FROM temperatures AS raw
+                               WHERE raw.type = 'raw' AND raw.timestamp >= temperatures.timestamp
+                                 AND raw.timestamp < temperatures.timestamp
+                                     + CASE temperatures.type WHEN 'hourly' THEN 3600 ELSE 86400 END),
+            sample_count = (SELECT COUNT(*) FROM temperatures AS raw
+                            WHERE raw.type = 'raw' AND raw.timestamp >= temperatures.timestamp
+                              AND raw.timestamp < temperatures.timestamp
+                                  + CASE temperatures.type WHEN 'hourly' THEN 3600 ELSE 86400 END)
+        WHERE type IN ('hourly', 'daily') AND sample_count IS NULL;
+
+        UPDATE temperatures SET temperature_sum = temperature, sample_count = 1
+        WHERE type IN ('hourly', 'daily') AND (sample_count IS NULL OR sample_count = 0);
+    )");
 }
 
-void DbManager::insertTemperature(time_t timestamp, double temperature, const std::string& type) {
-    const char* sql = "INSERT OR REPLACE INTO temperatures (timestamp, temperature, type) VALUES (?, ?, ?)";
-    sqlite3_stmt* stmt;
-    
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        throw std::runtime_error("Failed to prepare statement: " + std::string(sqlite3_errmsg(db)));
+// v3: every row belongs to a sensor. SQLite cannot change a primary key in
+// place, so the table is rebuilt with the key (sensor_id, type, timestamp)
+// and existing rows go to sensor 0. That key serves every range query, so
+// the old timestamp and type indexes are not recreated.
+void DbManager::migrateToV3() {
+    execute(R"(
+        CREATE TABLE temperatures_v3 (
+            sensor_id INTEGER NOT NULL DEFAULT 0,
+            timestamp INTEGER NOT NULL,
+            temperature REAL NOT NULL,
+            type TEXT NOT NULL,
+            temperature_sum REAL,
+            sample_count INTEGER,
+            PRIMARY KEY (sensor_id, type, timestamp)
+        );
+        INSERT INTO temperatures_v3 (sensor_id, timestamp, temperature, type, temperature_sum, sample_count)
+            SELECT 0, timestamp, temperature, type, temperature_sum, sample_count FROM temperatures;
+        DROP TABLE temperatures;
+        ALTER TABLE temperatures_v3 RENAME TO temperatures;
+    )");
+}
+
+void DbManager::createTables() {
+    std::lock_guard<std::mutex> lock(writeMutex);
+
+    static void (DbManager::*const steps[SCHEMA_VERSION])() = {
+        &DbManager::migrateToV1,
+        &DbManager::migrateToV2,
+        &DbManager::migrateToV3,
+    };
+
+    int version = schemaVersion();
+    if (version > SCHEMA_VERSION) {
+        throw std::runtime_error("Database schema version " + std::to_string(version) +
+                                 " is newer than supported version " + std::to_string(SCHEMA_VERSION));
+    }
+
+    for (; version < SCHEMA_VERSION; ++version) {
+        migrate(version + 1, steps[version]);
+    }
+
+    prepareStatements();
+}
+
+// Jumps from one sensor id to the next through the primary key instead of
+// scanning every row, so this costs one index lookup per sensor.
+std::vector<int> DbManager::storedSensors() {
+    SqliteStatement stmt(db, R"(
+        WITH RECURSIVE sensors(id) AS (
+            SELECT MIN(sensor_id) FROM temperatures
+            UNION ALL
+            SELECT (SELECT MIN(sensor_id) FROM temperatures WHERE sensor_id > id)
+            FROM sensors WHERE id IS NOT NULL
+        )
+        SELECT id FROM sensors WHERE id IS NOT NULL
+    )");
+
+    std::vector<int> sensors;
+    while (stmt.step()) {
+        sensors.push_back(sqlite3_column_int(stmt.get(), 0));
+    }
+    return sensors;
+}
+
+bool DbManager::loadBucket(int sensor, const std::string& type, RollupBucket& bucket) {
+    StatementScope scope(bucketStmt);
+    bucketStmt.bind(1, static_cast<sqlite3_int64>(sensor));
+    bucketStmt.bind(2, type);
+    if (!bucketStmt.step()) {
+        return false;
+    }
+
+    bucket.start = static_cast<time_t>(sqlite3_column_int64(bucketStmt.get(), 0));
+    bucket.sum = sqlite3_column_double(bucketStmt.get(), 1);
+    bucket.count = sqlite3_column_int64(bucketStmt.get(), 2);
+    return true;
+}
+
+void DbManager::warmStart() {
+    std::lock_guard<std::mutex> writeLock(writeMutex);
+    prepareStatements();
+
+    std::map<int, WarmState> states;
+    for (int sensor : storedSensors()) {
+        if (sensor < 0 || sensor >= MAX_SENSORS) {
+            continue;
+        }
+
+        WarmState& state = states[sensor];
+        {
+            StatementScope scope(currentStmt);
+            currentStmt.bind(1, static_cast<sqlite3_int64>(sensor));
+            if (currentStmt.step()) {
+                state.has_latest = true;
+                state.latest.timestamp = static_cast<time_t>(sqlite3_column_int64(currentStmt.get(), 0));
+                state.latest.temperature = sqlite3_column_double(currentStmt.get(), 1);
+                state.latest.sensor = sensor;
+            }
+        }
+        loadBucket(sensor, "hourly", state.hour);
+        loadBucket(sensor, "daily", state.day);
+
+        if (state.has_latest) {
+            publishLatest(state.latest);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(warmMutex);
+    warm = std::move(states);
+}
+
+void DbManager::addIngestEvents(IngestEvents events) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    ingestListeners.push_back(std::move(events));
+}
+
+void DbManager::notifyRangeChanged(int sensor, const std::string& type, time_t from, time_t to) {
+    for (const auto& listener : ingestListeners) {
+        if (listener.onRangeChanged) {
+            listener.onRangeChanged(sensor, type, from, to);
+        }
     }
-    
-    sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(timestamp));
-    sqlite3_bind_double(stmt, 2, temperature);
-    sqlite3_bind_text(stmt, 3, type.c_str(), -1, SQLITE_STATIC);
-    
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    
-    if (rc != SQLITE_DONE) {
-        throw std::runtime_error("Failed to insert temperature: " + std::string(sqlite3_errmsg(db)));
+}
+
+void DbManager::notifyRollupsChanged(const std::string& type, const RollupDeltas& deltas) {
+    for (auto it = deltas.begin(); it != deltas.end();) {
+        int sensor = it->first.first;
+        time_t from = it->first.second;
+        time_t to = from;
+        for (; it != deltas.end() && it->first.first == sensor; ++it) {
+            to = it->first.second;
+        }
+        notifyRangeChanged(sensor, type, from, to);
     }
+}
 
+std::map<int, WarmState> DbManager::warmState() const {
+    std::map<int, WarmState> states;
+    {
+        std::lock_guard<std::mutex> lock(warmMutex);
+        states = warm;
+    }
+    for (auto& [sensor, state] : states) {
+        state.has_latest = getLatestReading(sensor, state.latest);
+    }
+    return states;
+}
+
+void DbManager::prepareStatements() {
+    if (insertStmt) {
+        return;
+    }
+
+    beginStmt = SqliteStatement(db, "BEGIN IMMEDIATE");
+    commitStmt = SqliteStatement(db, "COMMIT");
+    rollbackStmt = SqliteStatement(db, "ROLLBACK");
+    insertStmt = SqliteStatement(db,
+        "INSERT OR REPLACE INTO temperatures (sensor_id, timestamp, temperature, type) VALUES (?, ?, ?, ?)");
+    // A raw reading that repeats an existing (sensor_id, type, timestamp) key
+    // is ignored, so it is never counted twice in the rollups below.
+    insertRawStmt = SqliteStatement(db,
+        "INSERT OR IGNORE INTO temperatures (sensor_id, timestamp, temperature, type) VALUES (?, ?, ?, 'raw')");
+
+    // Rollup rows keep the running sum and count of their raw readings,
+    // so adding readings is one upsert per bucket with no rescan.
+    rollupStmt = SqliteStatement(db, R"(
+        INSERT INTO temperatures (sensor_id, timestamp, temperature, type, temperature_sum, sample_count)
+        VALUES (?5, ?1, ?2 / ?3, ?4, ?2, ?3)
+        ON CONFLICT (sensor_id, type, timestamp) DO UPDATE SET
+            temperature_sum = temperature_sum + excluded.temperature_sum,
+            sample_count = sample_count + excluded.sample_count,
+            temperature = (temperature_sum + excluded.temperature_sum)
+                        / (sample_count + excluded.sample_count)
+    )");
+
+    currentStmt = SqliteStatement(db,
+        "SELECT timestamp, temperature FROM temperatures "
+        "WHERE sensor_id = ? AND type = 'raw' ORDER BY timestamp DESC LIMIT 1");
+
+    bucketStmt = SqliteStatement(db,
+        "SELECT timestamp, temperature_sum, sample_count FROM temperatures "
+        "WHERE sensor_id = ? AND type = ? ORDER BY timestamp DESC LIMIT 1");
+}
+
+void DbManager::insertRow(int sensor, time_t timestamp, double temperature, const std::string& type) {
+    insertStmt.bind(1, static_cast<sqlite3_int64>(sensor));
+    insertStmt.bind(2, static_cast<sqlite3_int64>(timestamp));
+    insertStmt.bind(3, temperature);
+    insertStmt.bind(4, type);
+    insertStmt.exec();
+}
+
+void DbManager::updateRollup(const std::string& type, const RollupKey& key, const RollupDelta& delta) {
+    rollupStmt.bind(1, static_cast<sqlite3_int64>(key.second));
+    rollupStmt.bind(2, delta.sum);
+    rollupStmt.bind(3, delta.count);
+    rollupStmt.bind(4, type);
+    rollupStmt.bind(5, static_cast<sqlite3_int64>(key.first));
+    rollupStmt.exec();
+}
+
+void DbManager::insertTemperature(int sensor, time_t timestamp, double temperature, const std::string& type) {
     if (type == "raw") {
-        const char* hourly_sql = R"(
-            INSERT OR REPLACE INTO temperatures (timestamp, temperature, type)
-            SELECT 
-                ? - (? % 3600),
-                AVG(temperature),
-                'hourly'
-            FROM temperatures
-            WHERE type = 'raw'
-                AND timestamp >= ? - (? % 3600)
-                AND timestamp < ? - (? % 3600) + 3600
-        )";
-
-        rc = sqlite3_prepare_v2(db, hourly_sql, -1, &stmt, nullptr);
-        if (rc != SQLITE_OK) {
-            throw std::runtime_error("Failed to prepare hourly statement: " + std::string(sqlite3_errmsg(db)));
+        insertTemperatures({{timestamp, temperature, sensor}});
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(writeMutex);
+    prepareStatements();
+    insertRow(sensor, timestamp, temperature, type);
+    notifyRangeChanged(sensor, type, timestamp, timestamp);
+}
+
+void DbManager::insertTemperatures(const std::vector<TemperatureRecord>& records) {
+    if (records.empty()) {
+        return;
+    }
+
+    for (const auto& record : records) {
+        if (record.sensor < 0 || record.sensor >= MAX_SENSORS) {
+            throw std::runtime_error("Sensor id out of range: " + std::to_string(record.sensor));
         }
+    }
+
+    std::lock_guard<std::mutex> lock(writeMutex);
+    prepareStatements();
+    beginStmt.exec();
+
+    try {
+        static const std::string hourly = "hourly";
+        static const std::string daily = "daily";
+        // Stored raw readings of one sensor span [first, latest.timestamp].
+        struct SensorSpan {
+            time_t first;
+            TemperatureRecord latest;
+        };
+        RollupDeltas hours;
+        RollupDeltas days;
+        std::map<int, SensorSpan> spans;
+        std::vector<TemperatureRecord> stored;
 
-        for (int i = 1; i <= 6; i += 2) {
-            sqlite3_bind_int64(stmt, i, static_cast<sqlite3_int64>(timestamp));
-            sqlite3_bind_int64(stmt, i + 1, static_cast<sqlite3_int64>(timestamp));
+        for (const auto& record : records) {
+            insertRawStmt.bind(1, static_cast<sqlite3_int64>(record.sensor));
+            insertRawStmt.bind(2, static_cast<sqlite3_int64>(record.timestamp));
+            insertRawStmt.bind(3, record.temperature);
+            insertRawStmt.exec();
+            if (sqlite3_changes(db) == 0) {
+                continue;
+            }
+            stored.push_back(record);
+
+            auto [span, added] = spans.emplace(record.sensor, SensorSpan{record.timestamp, record});
+            if (!added) {
+                span->second.first = std::min(span->second.first, record.timestamp);
+                if (record.timestamp >= span->second.latest.timestamp) {
+                    span->second.latest = record;
+                }
+            }
+
+            RollupDelta& hour = hours[{record.sensor, record.timestamp - record.timestamp % 3600}];
+            hour.sum += record.temperature;
+            ++hour.count;
+
+            RollupDelta& day = days[{record.sensor, record.timestamp - record.timestamp % 86400}];
+            day.sum += record.temperature;
+            ++day.count;
         }
 
-        rc = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
-
-        const char* daily_sql = R"(
-            INSERT OR REPLACE INTO temperatures (timestamp, temperature, type)
-            SELECT 
-                ? - (? % 86400),
-                AVG(temperature),
-                'daily'
-            FROM temperatures
-            WHERE type = 'hourly'
-                AND timestamp >= ? - (? % 86400)
-                AND timestamp < ? - (? % 86400) + 86400
-        )";
-
-        rc = sqlite3_prepare_v2(db, daily_sql, -1, &stmt, nullptr);
-        if (rc != SQLITE_OK) {
-            throw std::runtime_error("Failed to prepare daily statement: " + std::string(sqlite3_errmsg(db)));
+        for (const auto& [key, delta] : hours) {
+            updateRollup(hourly, key, delta);
+        }
+        for (const auto& [key, delta] : days) {
+            updateRollup(daily, key, delta);
         }
 
-        for (int i = 1; i <= 6; i += 2) {
-            sqlite3_bind_int64(stmt, i, static_cast<sqlite3_int64>(timestamp));
-            sqlite3_bind_int64(stmt, i + 1, static_cast<sqlite3_int64>(timestamp));
+        commitStmt.exec();
+
+        if (!stored.empty()) {
+            auto closed = applyToWarmState(hours, days);
+
+            for (const auto& [sensor, span] : spans) {
+                publishLatest(span.latest);
+                notifyRangeChanged(sensor, "raw", span.first, span.latest.timestamp);
+            }
+            notifyRollupsChanged(hourly, hours);
+            notifyRollupsChanged(daily, days);
+
+            for (const auto& listener : ingestListeners) {
+                if (listener.onReading) {
+                    for (const auto& record : stored) {
+                        listener.onReading(record);
+                    }
+                }
+                if (listener.onBucketClosed) {
+                    for (const auto& closedBucket : closed) {
+                        listener.onBucketClosed(closedBucket.sensor, closedBucket.type, closedBucket.bucket);
+                    }
+                }
+            }
+        }
+    } catch (...) {
+        StatementScope scope(rollbackStmt);
+        sqlite3_step(rollbackStmt.get());
+        throw;
+    }
+}
+
+std::vector<DbManager::ClosedBucket> DbManager::applyToWarmState(const RollupDeltas& hours,
+                                                                const RollupDeltas& days) {
+    std::vector<ClosedBucket> closed;
+    auto advance = [this, &closed](const char* type, RollupBucket WarmState::*which,
+                                   const RollupDeltas& deltas) {
+        for (const auto& [key, delta] : deltas) {
+            auto [sensor, start] = key;
+            RollupBucket& bucket = warm[sensor].*which;
+            if (start > bucket.start || bucket.count == 0) {
+                if (bucket.count > 0) {
+                    closed.push_back({sensor, type, bucket});
+                }
+                bucket = RollupBucket{start, 0.0, 0};
+            }
+            if (start == bucket.start) {
+                bucket.sum += delta.sum;
+                bucket.count += delta.count;
+            }
         }
+    };
+
+    std::lock_guard<std::mutex> lock(warmMutex);
+    advance("hourly", &WarmState::hour, hours);
+    advance("daily", &WarmState::day, days);
+    return closed;
+}
 
-        rc = sqlite3_step(stmt);
-        sqlite3_finalize(stmt);
+// Called with writeMutex held, which makes this the only writer of latestReadings.
+void DbManager::publishLatest(const TemperatureRecord& record) {
+    LatestReading& cell = latestReadings[record.sensor];
+    TemperatureRecord current;
+    if (!cell.load(current) || record.timestamp >= current.timestamp) {
+        cell.publish(record);
     }
 }
 
-double DbManager::getCurrentTemperature() {
-    const char* sql = "SELECT temperature FROM temperatures WHERE type = 'raw' ORDER BY timestamp DESC LIMIT 1";
-    sqlite3_stmt* stmt;
-    
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        throw std::runtime_error("Failed to prepare statement: " + std::string(sqlite3_errmsg(db)));
-    }
-    
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_ROW) {
-        sqlite3_finalize(stmt);
-        throw std::runtime_error("No temperature data available");
-    }
-    
-    double temperature = sqlite3_column_double(stmt, 0);
-    sqlite3_finalize(stmt);
-    
-    return temperature;
-}
-
-std::vector<TemperatureRecord> DbManager::getTemperatures(const std::string& type, time_t start, time_t end) {
-    const char* sql = "SELECT timestamp, temperature FROM temperatures "
-                     "WHERE type = ? AND timestamp >= ? AND timestamp <= ? "
-                     "ORDER BY timestamp ASC";
-    
-    sqlite3_stmt* stmt;
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        throw std::runtime_error("Failed to prepare statement: " + std::string(sqlite3_errmsg(db)));
+bool DbManager::getLatestReading(int sensor, TemperatureRecord& record) const {
+    if (sensor < 0 || sensor >= MAX_SENSORS || !latestReadings[sensor].load(record)) {
+        return false;
     }
-    
-    sqlite3_bind_text(stmt, 1, type.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(start));
-    sqlite3_bind_int64(stmt, 3, static_cast<sqlite3_int64>(end));
-    
+    record.sensor = sensor;
+    return true;
+}
+
+std::vector<TemperatureRecord> DbManager::getTemperatures(int sensor, const std::string& type, time_t start, time_t end) {
     std::vector<TemperatureRecord> records;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
+    readTemperatures(sensor, type, start, end, 0, records);
+    return records;
+}
+
+size_t DbManager::readTemperatures(int sensor, const std::string& type, time_t start, time_t end,
+                                   size_t limit, std::vector<TemperatureRecord>& out) {
+    auto connection = readPool->acquire();
+    SqliteStatement& stmt = connection->statement(RANGE_SQL);
+    StatementScope scope(stmt);
+
+    stmt.bind(1, static_cast<sqlite3_int64>(sensor));
+    stmt.bind(2, type);
+    stmt.bind(3, static_cast<sqlite3_int64>(start));
+    stmt.bind(4, static_cast<sqlite3_int64>(end));
+    // A negative LIMIT means no limit in SQLite.
+    stmt.bind(5, limit > 0 ? static_cast<sqlite3_int64>(limit) : sqlite3_int64(-1));
+
+    size_t count = 0;
+    while (stmt.step()) {
         TemperatureRecord record;
-        record.timestamp = static_cast<time_t>(sqlite3_column_int64(stmt, 0));
-        record.temperature = sqlite3_column_double(stmt, 1);
-        records.push_back(record);
+        record.timestamp = static_cast<time_t>(sqlite3_column_int64(stmt.get(), 0));
+        record.temperature = sqlite3_column_double(stmt.get(), 1);
+        record.sensor = sensor;
+        out.push_back(record);
+        ++count;
     }
-    
-    sqlite3_finalize(stmt);
-    return records;
-} 
\ No newline at end of file
+    return count;
+}
+
+void DbManager::summarizeBuckets(int sensor, const std::string& type, time_t start, time_t end,
+                                 long long buckets, std::vector<BucketSummary>& out) {
+    auto connection = readPool->acquire();
+    SqliteStatement& stmt = connection->statement(BUCKETS_SQL);
+    StatementScope scope(stmt);
+
+    stmt.bind(1, static_cast<sqlite3_int64>(sensor));
+    stmt.bind(2, type);
+    stmt.bind(3, static_cast<sqlite3_int64>(start));
+    stmt.bind(4, static_cast<sqlite3_int64>(end));
+    stmt.bind(5, static_cast<double>(buckets));
+    stmt.bind(6, end >= start ? static_cast<double>(end - start) + 1.0 : 1.0);
+
+    while (stmt.step()) {
+        BucketSummary summary;
+        summary.bucket = sqlite3_column_int64(stmt.get(), 0);
+        summary.count = static_cast<size_t>(sqlite3_column_int64(stmt.get(), 1));
+        summary.timestamp_sum = sqlite3_column_double(stmt.get(), 2);
+        summary.temperature_sum = sqlite3_column_double(stmt.get(), 3);
+        summary.last.timestamp = static_cast<time_t>(sqlite3_column_int64(stmt.get(), 4));
+        summary.last.temperature = sqlite3_column_double(stmt.get(), 5);
+        summary.last.sensor = sensor;
+        out.push_back(summary);
+    }
+}
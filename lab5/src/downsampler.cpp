@@ -0,0 +1,168 @@
+#include "downsampler.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+DownsampleMethod parseDownsampleMethod(std::string_view name) {
+    if (name == "lttb") return DownsampleMethod::Lttb;
+    if (name == "minmax") return DownsampleMethod::MinMax;
+    if (name == "avg") return DownsampleMethod::Average;
+    throw std::invalid_argument("Unknown downsampling method: " + std::string(name));
+}
+
+Downsampler::Downsampler(DownsampleMethod method, size_t points, time_t start, time_t end)
+    : method_(method)
+    , start_(start)
+    , span_(end >= start ? static_cast<double>(end - start) + 1.0 : 1.0)
+    , current_(-1)
+    , seen_(0)
+    , anchor_{0, 0.0}
+    , pending_{0, 0.0}
+    , best_{0, 0.0}
+    , best_area_(-1.0)
+    , target_timestamp_(0.0)
+    , target_temperature_(0.0)
+    , next_summary_(0) {
+    if (points < MIN_DOWNSAMPLE_POINTS || points > MAX_DOWNSAMPLE_POINTS) {
+        throw std::invalid_argument("Number of points must be between " + std::to_string(MIN_DOWNSAMPLE_POINTS) +
+                                    " and " + std::to_string(MAX_DOWNSAMPLE_POINTS));
+    }
+    long long limit = static_cast<long long>(points);
+    switch (method_) {
+        case DownsampleMethod::Lttb: buckets_ = limit - 2; break;   // plus first and last
+        case DownsampleMethod::MinMax: buckets_ = limit / 2; break; // two points each
+        default: buckets_ = limit; break;
+    }
+}
+
+void Downsampler::setSummaries(std::vector<BucketSummary> summaries) {
+    summaries_ = std::move(summaries);
+    next_summary_ = 0;
+}
+
+long long Downsampler::bucketOf(time_t timestamp) const {
+    double offset = static_cast<double>(timestamp - start_);
+    long long bucket = static_cast<long long>(std::floor(offset * buckets_ / span_));
+    return std::min(std::max(bucket, 0LL), buckets_ - 1);
+}
+
+void Downsampler::add(const TemperatureRecord& record, std::vector<TemperatureRecord>& out) {
+    if (method_ == DownsampleMethod::Lttb) {
+        if (seen_++ == 0) {
+            out.push_back(record);
+            anchor_ = record;
+        } else {
+            if (seen_ > 2) {
+                considerLttb(pending_, out);
+            }
+            pending_ = record;
+        }
+        return;
+    }
+
+    long long bucket = bucketOf(record.timestamp);
+    if (bucket != current_ && current_ >= 0) {
+        closeBucket(out);
+    }
+    current_ = bucket;
+
+    if (summary_.count == 0 || record.temperature < summary_.min.temperature) summary_.min = record;
+    if (summary_.count == 0 || record.temperature > summary_.max.temperature) summary_.max = record;
+    summary_.timestamp_sum += static_cast<double>(record.timestamp);
+    summary_.temperature_sum += record.temperature;
+    ++summary_.count;
+}
+
+void Downsampler::closeBucket(std::vector<TemperatureRecord>& out) {
+    if (summary_.count == 0) {
+        return;
+    }
+
+    if (method_ == DownsampleMethod::Average) {
+        time_t timestamp = static_cast<time_t>(std::llround(summary_.timestamp_sum / summary_.count));
+        out.push_back({timestamp, summary_.temperature_sum / summary_.count});
+    } else if (summary_.min.timestamp == summary_.max.timestamp) {
+        out.push_back(summary_.min);
+    } else if (summary_.min.timestamp < summary_.max.timestamp) {
+        out.push_back(summary_.min);
+        out.push_back(summary_.max);
+    } else {
+        out.push_back(summary_.max);
+        out.push_back(summary_.min);
+    }
+    summary_ = Summary();
+}
+
+void Downsampler::considerLttb(const TemperatureRecord& record, std::vector<TemperatureRecord>& out) {
+    long long bucket = bucketOf(record.timestamp);
+    if (bucket != current_) {
+        if (current_ >= 0) {
+            anchor_ = best_;
+            out.push_back(best_);
+        }
+        current_ = bucket;
+        best_area_ = -1.0;
+        aimAfter(bucket);
+    }
+
+    // Twice the triangle area; the factor does not change which point wins.
+    double ax = static_cast<double>(anchor_.timestamp);
+    double ay = anchor_.temperature;
+    double area = std::fabs((ax - target_timestamp_) * (record.temperature - ay) -
+                            (ax - static_cast<double>(record.timestamp)) * (target_temperature_ - ay));
+    if (area > best_area_) {
+        best_area_ = area;
+        best_ = record;
+    }
+}
+
+void Downsampler::aimAfter(long long bucket) {
+    while (next_summary_ < summaries_.size() && summaries_[next_summary_].bucket <= bucket) {
+        ++next_summary_;
+    }
+
+    if (summaries_.empty()) {
+        // Nothing to aim at: every reading ties and the first one is kept.
+        target_timestamp_ = static_cast<double>(anchor_.timestamp);
+        target_temperature_ = anchor_.temperature;
+        return;
+    }
+
+    // The last reading of the range is kept on its own, so it is left out
+    // of its bucket's average; the final bucket aims at that reading.
+    const BucketSummary& last_bucket = summaries_.back();
+    if (next_summary_ == summaries_.size() ||
+        (next_summary_ + 1 == summaries_.size() && last_bucket.count < 2)) {
+        target_timestamp_ = static_cast<double>(last_bucket.last.timestamp);
+        target_temperature_ = last_bucket.last.temperature;
+        return;
+    }
+
+    const BucketSummary& next = summaries_[next_summary_];
+    double timestamp_sum = next.timestamp_sum;
+    double temperature_sum = next.temperature_sum;
+    double count = static_cast<double>(next.count);
+    if (next_summary_ + 1 == summaries_.size()) {
+        timestamp_sum -= static_cast<double>(next.last.timestamp);
+        temperature_sum -= next.last.temperature;
+        count -= 1.0;
+    }
+    target_timestamp_ = timestamp_sum / count;
+    target_temperature_ = temperature_sum / count;
+}
+
+void Downsampler::finish(std::vector<TemperatureRecord>& out) {
+    if (method_ != DownsampleMethod::Lttb) {
+        closeBucket(out);
+        return;
+    }
+
+    if (seen_ < 2) {
+        return;
+    }
+
+    if (current_ >= 0) {
+        out.push_back(best_);
+    }
+    out.push_back(pending_);
+}
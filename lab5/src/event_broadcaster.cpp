@@ -0,0 +1,32 @@
+#include "event_broadcaster.h"
+
+uint64_t EventBroadcaster::subscribe(Subscriber subscriber, int channel) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [key, message] : latest_) {
+        if (channel == all_channels || key.first == channel) {
+            subscriber(message);
+        }
+    }
+
+    uint64_t id = next_id_++;
+    subscribers_.emplace(id, Subscription{channel, std::move(subscriber)});
+    return id;
+}
+
+void EventBroadcaster::unsubscribe(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscribers_.erase(id);
+}
+
+void EventBroadcaster::publish(const std::string& event, const std::string& data, int channel) {
+    auto message = std::make_shared<const std::string>("event: " + event + "\ndata: " + data + "\n\n");
+
+    // Delivering under the lock keeps every subscriber's events in publish order.
+    std::lock_guard<std::mutex> lock(mutex_);
+    latest_[{channel, event}] = message;
+    for (const auto& [id, subscription] : subscribers_) {
+        if (subscription.channel == all_channels || subscription.channel == channel) {
+            subscription.deliver(message);
+        }
+    }
+}
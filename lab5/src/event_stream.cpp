@@ -0,0 +1,106 @@
+#include "event_stream.h"
+#include <boost/asio/post.hpp>
+#include <boost/beast/version.hpp>
+#include <iostream>
+#include <sstream>
+
+EventStream::EventStream(beast::tcp_stream&& stream, std::shared_ptr<EventBroadcaster> broadcaster, int channel)
+    : stream_(std::move(stream))
+    , broadcaster_(std::move(broadcaster))
+    , channel_(channel)
+    , subscription_(0)
+    , writing_(false)
+    , closed_(false) {
+}
+
+void EventStream::start(unsigned version) {
+    // No Content-Length and no keep-alive: the body runs until either side closes.
+    http::response_header<> header;
+    header.version(version);
+    header.result(http::status::ok);
+    header.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+    header.set(http::field::content_type, "text/event-stream");
+    header.set(http::field::cache_control, "no-cache");
+    header.set(http::field::connection, "close");
+    header.set(http::field::access_control_allow_origin, "*");
+
+    std::ostringstream head;
+    head << header << "retry: 3000\n\n";
+    enqueue(std::make_shared<const std::string>(head.str()));
+
+    // Events are published from the ingest thread; hop onto this stream's strand.
+    std::weak_ptr<EventStream> weak = shared_from_this();
+    auto executor = stream_.get_executor();
+    subscription_ = broadcaster_->subscribe(
+        [weak, executor](const EventBroadcaster::Message& message) {
+            boost::asio::post(executor, [weak, message]() {
+                if (auto self = weak.lock()) {
+                    self->enqueue(message);
+                }
+            });
+        }, channel_);
+
+    do_read();
+}
+
+void EventStream::enqueue(EventBroadcaster::Message message) {
+    if (closed_) {
+        return;
+    }
+
+    if (queue_.size() >= max_queued) {
+        // The front entry may be in flight, so drop the one behind it.
+        queue_.erase(queue_.begin() + 1);
+    }
+    queue_.push_back(std::move(message));
+
+    if (!writing_) {
+        do_write();
+    }
+}
+
+void EventStream::do_write() {
+    writing_ = true;
+    stream_.expires_after(write_timeout);
+    boost::asio::async_write(stream_, boost::asio::buffer(*queue_.front()),
+        beast::bind_front_handler(&EventStream::on_write, shared_from_this()));
+}
+
+void EventStream::on_write(beast::error_code ec, std::size_t) {
+    writing_ = false;
+    if (ec) {
+        return close();
+    }
+
+    queue_.pop_front();
+    if (!queue_.empty()) {
+        return do_write();
+    }
+    stream_.expires_never();
+}
+
+// Anything the client sends after the request is read and discarded. The
+// read failing, with EOF or an error, is how a client that has gone away
+// is noticed between events.
+void EventStream::do_read() {
+    stream_.async_read_some(boost::asio::buffer(discard_),
+        [self = shared_from_this()](beast::error_code ec, std::size_t) {
+            if (ec) {
+                return self->close();
+            }
+            self->do_read();
+        });
+}
+
+void EventStream::close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+    // queue_ is left alone: a write still in flight points into its front entry.
+    broadcaster_->unsubscribe(subscription_);
+
+    beast::error_code ec;
+    stream_.socket().shutdown(tcp::socket::shutdown_both, ec);
+    stream_.socket().close(ec);
+}
@@ -5,8 +5,10 @@
 #include <boost/beast/http.hpp>
 #include <boost/beast/version.hpp>
 #include <boost/asio/dispatch.hpp>
+#include <boost/asio/strand.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
 #include <memory>
@@ -20,45 +22,90 @@ namespace fs = boost::filesystem;
 using tcp = boost::asio::ip::tcp;
 
 HttpServer::HttpServer(const std::string& address, unsigned short port, 
-                     const std::string& doc_root, std::shared_ptr<DbManager> db_manager)
-    : address_(address)
+                     const std::string& doc_root, std::shared_ptr<DbManager> db_manager,
+                     std::shared_ptr<EventBroadcaster> events, size_t threads)
+    : threads_(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency()))
+    , io_context_(static_cast<int>(threads_))
+    , acceptor_(boost::asio::make_strand(io_context_))
+    , address_(address)
     , port_(port)
-    , doc_root_(doc_root)
-    , api_handler_(std::make_shared<ApiHandler>(db_manager)) {
+    , assets_(std::make_shared<const AssetCache>(doc_root))
+    , api_handler_(std::make_shared<ApiHandler>(db_manager))
+    , events_(std::move(events)) {
 }
 
 void HttpServer::start() {
     try {
-        tcp::acceptor acceptor(io_context_, tcp::endpoint(boost::asio::ip::make_address(address_), port_));
+        tcp::endpoint endpoint(boost::asio::ip::make_address(address_), port_);
+        acceptor_.open(endpoint.protocol());
+        acceptor_.set_option(boost::asio::socket_base::reuse_address(true));
+        acceptor_.bind(endpoint);
+        acceptor_.listen(boost::asio::socket_base::max_listen_connections);
         
-        do_accept(acceptor);
+        do_accept();
         
-        io_context_.run();
+        std::vector<std::thread> workers;
+        workers.reserve(threads_ - 1);
+        try {
+            for (size_t i = 1; i < threads_; ++i) {
+                workers.emplace_back([this] { run(); });
+            }
+        } catch (...) {
+            // A thread could not be started: stop the ones that were.
+            io_context_.stop();
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            throw;
+        }
+        run();
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
     } catch (const std::exception& e) {
         std::cerr << "Error in server: " << e.what() << std::endl;
         throw;
     }
 }
 
+void HttpServer::run() {
+    // An exception thrown by a handler leaves run(); log it and go back to
+    // serving, so one bad request cannot take down a thread or the server.
+    for (;;) {
+        try {
+            io_context_.run();
+            break;
+        } catch (const std::exception& e) {
+            std::cerr << "Error in server thread: " << e.what() << std::endl;
+        }
+    }
+}
+
 void HttpServer::stop() {
     boost::asio::post(io_context_, [this]() {
         io_context_.stop();
     });
 }
 
-void HttpServer::do_accept(tcp::acceptor& acceptor) {
-    acceptor.async_accept(
-        [this, &acceptor](boost::system::error_code ec, tcp::socket socket) {
+void HttpServer::do_accept() {
+    // Every connection gets its own strand, so a session's handlers never run
+    // concurrently even though the io_context is served by several threads.
+    acceptor_.async_accept(
+        boost::asio::make_strand(io_context_),
+        [this](boost::system::error_code ec, tcp::socket socket) {
             if (!ec) {
                 std::make_shared<HttpSession>(
                     std::move(socket),
-                    doc_root_,
-                    api_handler_
+                    assets_,
+                    api_handler_,
+                    events_
                 )->start();
-                
-                do_accept(acceptor);
-            } else if (ec != boost::asio::error::operation_aborted) {
+            } else if (ec == boost::asio::error::operation_aborted) {
+                return;
+            } else {
                 std::cerr << "Accept error: " << ec.message() << std::endl;
             }
+            do_accept();
         });
-} 
\ No newline at end of file
+}
@@ -1,20 +1,80 @@
 #include "http_session.h"
-#include <boost/algorithm/string.hpp>
+#include "event_stream.h"
+#include <boost/asio/dispatch.hpp>
+#include <charconv>
 #include <iostream>
+#include <string_view>
 
-HttpSession::HttpSession(tcp::socket&& socket, std::string doc_root, std::shared_ptr<ApiHandler> api_handler)
-    : socket_(std::move(socket))
-    , doc_root_(std::move(doc_root))
-    , api_handler_(std::move(api_handler)) {
+namespace {
+
+std::string_view toStringView(beast::string_view s) {
+    return std::string_view(s.data(), s.size());
+}
+
+// The whole value must be a number.
+template<typename T>
+bool parseNumber(std::string_view s, T& value) {
+    auto result = std::from_chars(s.data(), s.data() + s.size(), value);
+    return result.ec == std::errc() && result.ptr == s.data() + s.size();
+}
+
+} // namespace
+
+HttpSession::HttpSession(tcp::socket&& socket, std::shared_ptr<const AssetCache> assets, std::shared_ptr<ApiHandler> api_handler,
+                         std::shared_ptr<EventBroadcaster> events)
+    : stream_(std::move(socket))
+    , requests_served_(0)
+    , assets_(std::move(assets))
+    , api_handler_(std::move(api_handler))
+    , events_(std::move(events)) {
 }
 
 void HttpSession::start() {
-    http::async_read(socket_, buffer_, request_,
-        [self = shared_from_this()](beast::error_code ec, std::size_t) {
-            if (!ec) {
-                self->handle_request();
-            }
-        });
+    // Hop onto the session's strand before touching the socket.
+    boost::asio::dispatch(stream_.get_executor(),
+        beast::bind_front_handler(&HttpSession::do_read, shared_from_this()));
+}
+
+void HttpSession::do_read() {
+    // buffer_ is kept: it may already hold the next pipelined request.
+    request_ = {};
+    stream_.expires_after(idle_timeout);
+
+    http::async_read(stream_, buffer_, request_,
+        beast::bind_front_handler(&HttpSession::on_read, shared_from_this()));
+}
+
+void HttpSession::on_read(beast::error_code ec, std::size_t) {
+    if (ec == http::error::end_of_stream) {
+        return do_close();
+    }
+    if (ec) {
+        return;
+    }
+
+    ++requests_served_;
+    handle_request();
+}
+
+bool HttpSession::keep_alive() const {
+    return request_.keep_alive() && requests_served_ < max_requests;
+}
+
+void HttpSession::on_write(bool close, beast::error_code ec, std::size_t) {
+    if (ec) {
+        std::cerr << "Error writing response: " << ec.message() << std::endl;
+        return;
+    }
+
+    if (close) {
+        return do_close();
+    }
+    do_read();
+}
+
+void HttpSession::do_close() {
+    beast::error_code ec;
+    stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
 }
 
 void HttpSession::handle_request() {
@@ -49,14 +109,8 @@ void HttpSession::handle_request() {
         return;
     }
 
-    std::string path = doc_root_;
-    path.append(request_.target().data(), request_.target().size());
-    if (request_.target().back() == '/') {
-        path.append("index.html");
-    }
-
-    if (fs::exists(path)) {
-        send_file(path);
+    if (const AssetCache::Asset* asset = assets_->find(toStringView(request_.target()))) {
+        send_asset(*asset);
     } else {
         http::response<http::string_body> res{http::status::not_found, request_.version()};
         res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
@@ -69,104 +123,264 @@ void HttpSession::handle_request() {
     }
 }
 
+const HttpSession::Route HttpSession::routes[] = {
+    {"/api/sensors", &HttpSession::handle_sensors},
+    {"/api/temperature/current", &HttpSession::handle_current},
+    {"/api/temperature/history", &HttpSession::handle_history},
+    {"/api/temperature/stream", &HttpSession::handle_stream},
+};
+
 bool HttpSession::handle_api_request() {
-    std::string target(request_.target());
-    
-    if (!boost::starts_with(target, "/api/")) {
-        return false;
-    }
-    
-    http::response<http::string_body> res;
-    
-    if (target == "/api/temperature/current") {
-        res = api_handler_->handleCurrentTemperature();
-    }
-    else if (boost::starts_with(target, "/api/temperature/history")) {
-        std::string type, start, end;
-        std::string query = target.substr(target.find('?') + 1);
-        std::vector<std::string> params;
-        boost::split(params, query, boost::is_any_of("&"));
-        
-        for (const auto& param : params) {
-            std::vector<std::string> kv;
-            boost::split(kv, param, boost::is_any_of("="));
-            if (kv.size() == 2) {
-                if (kv[0] == "type") type = kv[1];
-                else if (kv[0] == "start") start = kv[1];
-                else if (kv[0] == "end") end = kv[1];
-            }
-        }
-        
-        if (type.empty() || start.empty() || end.empty()) {
-            res.result(http::status::bad_request);
-            res.set(http::field::content_type, "application/json");
-            res.body() = R"({"error": "Missing required parameters"})";
-        } else {
-            res = api_handler_->handleTemperatureHistory(type, start, end);
+    auto [path, query] = QueryString::splitTarget(toStringView(request_.target()));
+
+    for (const Route& route : routes) {
+        if (route.path == path) {
+            (this->*route.handler)(query);
+            return true;
         }
     }
-    else {
+    return false;
+}
+
+bool HttpSession::parse_sensor(const QueryString& params, int& sensor) {
+    QueryString::Buffer buffer;
+    std::string_view value;
+    if (params.has("sensor") &&
+        (!params.get("sensor", buffer, value) || !parseNumber(value, sensor) || sensor < 0 || sensor >= MAX_SENSORS)) {
+        auto res = ApiHandler::errorResponse(http::status::bad_request, "Invalid parameter: sensor");
+        add_cors_headers(res);
+        send_response(std::move(res));
         return false;
     }
-    
+    return true;
+}
+
+void HttpSession::handle_current(const QueryString& params) {
+    int sensor = 0;
+    if (!parse_sensor(params, sensor)) {
+        return;
+    }
+    auto res = api_handler_->handleCurrentTemperature(sensor);
+    add_cors_headers(res);
+    send_response(std::move(res));
+}
+
+void HttpSession::handle_sensors(const QueryString&) {
+    auto res = api_handler_->handleSensors();
     add_cors_headers(res);
     send_response(std::move(res));
-    return true;
+}
+
+void HttpSession::handle_stream(const QueryString& params) {
+    // Without ?sensor= the stream carries the events of every sensor.
+    int sensor = EventBroadcaster::all_channels;
+    if (!parse_sensor(params, sensor)) {
+        return;
+    }
+    // The stream owns the connection from here on; this session ends.
+    std::make_shared<EventStream>(std::move(stream_), events_, sensor)->start(request_.version());
+}
+
+void HttpSession::handle_history(const QueryString& params) {
+    auto fail = [this](http::status status, const std::string& message) {
+        auto res = ApiHandler::errorResponse(status, message);
+        add_cors_headers(res);
+        send_response(std::move(res));
+    };
+
+    QueryString::Buffer buffer;
+    std::string_view value;
+    HistoryQuery query;
+    if (!parse_sensor(params, query.sensor)) {
+        return;
+    }
+
+    if (!params.has("type") || !params.has("start") || !params.has("end")) {
+        return fail(http::status::bad_request, "Missing required parameters");
+    }
+    // Present but empty, or too long to decode, is invalid rather than missing.
+    if (!params.get("type", buffer, value) || value.empty()) {
+        return fail(http::status::bad_request, "Invalid parameter: type");
+    }
+    query.type.assign(value.data(), value.size());
+    if (!params.get("start", buffer, value) || !parseNumber(value, query.start)) {
+        return fail(http::status::bad_request, "Invalid parameter: start");
+    }
+    if (!params.get("end", buffer, value) || !parseNumber(value, query.end)) {
+        return fail(http::status::bad_request, "Invalid parameter: end");
+    }
+
+    // ?format= wins over Accept, which browsers fill in on their own.
+    if (params.has("format")) {
+        if (!params.get("format", buffer, value) || (value != "json" && value != "binary")) {
+            return fail(http::status::bad_request, "Invalid parameter: format");
+        }
+        query.format = value == "binary" ? HistoryFormat::Columnar : HistoryFormat::Json;
+    } else if (request_[http::field::accept].find("application/octet-stream") != beast::string_view::npos) {
+        query.format = HistoryFormat::Columnar;
+    }
+
+    if (params.has("points") &&
+        (!params.get("points", buffer, value) || !parseNumber(value, query.points) || query.points < MIN_DOWNSAMPLE_POINTS || query.points > MAX_DOWNSAMPLE_POINTS)) {
+        return fail(http::status::bad_request, "Invalid parameter: points");
+    }
+
+    try {
+        if (params.has("method")) {
+            if (!params.get("method", buffer, value)) {
+                return fail(http::status::bad_request, "Invalid parameter: method");
+            }
+            query.method = parseDownsampleMethod(value);
+        }
+    } catch (const std::exception& e) {
+        return fail(http::status::bad_request, e.what());
+    }
+
+    if (auto cached = api_handler_->cachedTemperatureHistory(query)) {
+        return send_cached(std::move(cached));
+    }
+
+    try {
+        ChunkSource body = api_handler_->streamTemperatureHistory(query);
+        http::response<http::buffer_body> header{http::status::ok, request_.version()};
+        header.set(http::field::content_type, ApiHandler::contentType(query.format));
+        header.set(http::field::vary, "Accept");
+        add_cors_headers(header);
+        send_chunked(std::move(header), std::move(body));
+    } catch (const std::exception& e) {
+        fail(http::status::internal_server_error, e.what());
+    }
 }
 
 void HttpSession::send_response(http::response<http::string_body>&& msg) {
+    msg.version(request_.version());
+    msg.keep_alive(keep_alive());
+    msg.prepare_payload();
+
     auto sp = std::make_shared<http::response<http::string_body>>(std::move(msg));
     
-    http::async_write(socket_, *sp,
-        [self = shared_from_this(), sp](beast::error_code ec, std::size_t) {
+    stream_.expires_after(write_timeout);
+    http::async_write(stream_, *sp,
+        [self = shared_from_this(), sp](beast::error_code ec, std::size_t bytes) {
+            self->on_write(sp->need_eof(), ec, bytes);
+        });
+}
+
+struct HttpSession::ChunkedWrite {
+    explicit ChunkedWrite(http::response<http::buffer_body>&& header, ChunkSource source)
+        : response(std::move(header)), serializer(response), source(std::move(source)) {}
+
+    http::response<http::buffer_body> response;
+    http::response_serializer<http::buffer_body> serializer;
+    ChunkSource source;
+    std::string chunk;
+};
+
+void HttpSession::send_chunked(http::response<http::buffer_body>&& header, ChunkSource source) {
+    header.version(request_.version());
+    header.keep_alive(keep_alive());
+    header.chunked(true);
+
+    auto write = std::make_shared<ChunkedWrite>(std::move(header), std::move(source));
+    stream_.expires_after(write_timeout);
+    http::async_write_header(stream_, write->serializer,
+        [self = shared_from_this(), write](beast::error_code ec, std::size_t) {
             if (ec) {
                 std::cerr << "Error writing response: " << ec.message() << std::endl;
+                return;
             }
-            self->socket_.shutdown(tcp::socket::shutdown_send, ec);
+            self->write_chunk(write);
         });
 }
 
-void HttpSession::send_file(const std::string& path) {
-    http::response<http::file_body> res;
-    res.version(11);
-    res.result(http::status::ok);
+// The chunk buffer is reused for every piece, so a response of any size
+// needs only as much memory as its largest piece.
+void HttpSession::write_chunk(std::shared_ptr<ChunkedWrite> write) {
+    write->chunk.clear();
+    bool more = true;
+    try {
+        while (more && write->chunk.empty()) {
+            more = write->source(write->chunk);
+        }
+    } catch (const std::exception& e) {
+        // The status line is already sent; a dropped connection is the only
+        // way left to tell the client the body is incomplete.
+        std::cerr << "Error producing response: " << e.what() << std::endl;
+        return do_close();
+    }
+
+    auto& body = write->response.body();
+    body.data = write->chunk.empty() ? nullptr : &write->chunk[0];
+    body.size = write->chunk.size();
+    body.more = more;
+
+    // Each chunk gets the full write_timeout, so a long response is only
+    // cut off if the client stops taking data, not for its total length.
+    stream_.expires_after(write_timeout);
+    http::async_write(stream_, write->serializer,
+        [self = shared_from_this(), write, more](beast::error_code ec, std::size_t bytes) {
+            if (ec == http::error::need_buffer) {
+                ec = {};
+            }
+            if (ec || !more) {
+                return self->on_write(write->response.need_eof(), ec, bytes);
+            }
+            self->write_chunk(write);
+        });
+}
+
+void HttpSession::send_cached(std::shared_ptr<const ResponseCache::Entry> entry) {
+    http::response<http::span_body<char const>> res{http::status::ok, request_.version()};
+    res.set(http::field::content_type, entry->content_type);
+    res.set(http::field::cache_control, "no-cache");
+    res.set(http::field::etag, entry->etag);
+    res.set(http::field::vary, "Accept");
+    add_cors_headers(res);
+
+    beast::string_view if_none_match = request_[http::field::if_none_match];
+    if (!if_none_match.empty() && if_none_match.find(entry->etag) != beast::string_view::npos) {
+        res.result(http::status::not_modified);
+    } else {
+        res.body() = {entry->body->data(), entry->body->size()};
+        res.content_length(entry->body->size());
+    }
+    res.keep_alive(keep_alive());
+
+    auto sp = std::make_shared<http::response<http::span_body<char const>>>(std::move(res));
+    stream_.expires_after(write_timeout);
+    http::async_write(stream_, *sp,
+        [self = shared_from_this(), sp, entry](beast::error_code ec, std::size_t bytes) {
+            self->on_write(sp->need_eof(), ec, bytes);
+        });
+}
+
+void HttpSession::send_asset(const AssetCache::Asset& asset) {
+    AssetCache::Variant variant = AssetCache::select(asset, toStringView(request_[http::field::accept_encoding]));
+
+    http::response<http::span_body<char const>> res{http::status::ok, request_.version()};
     res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-    
-    auto const ext = fs::path(path).extension().string();
-    if (ext == ".html") res.set(http::field::content_type, "text/html");
-    else if (ext == ".js") res.set(http::field::content_type, "application/javascript");
-    else if (ext == ".css") res.set(http::field::content_type, "text/css");
-    else if (ext == ".json") res.set(http::field::content_type, "application/json");
-    else res.set(http::field::content_type, "application/octet-stream");
-    
+    res.set(http::field::content_type, asset.content_type);
+    res.set(http::field::cache_control, asset.cache_control);
+    res.set(http::field::etag, variant.etag);
+    res.set(http::field::vary, "Accept-Encoding");
     add_cors_headers(res);
-    
-    beast::error_code ec;
-    http::file_body::value_type body;
-    body.open(path.c_str(), beast::file_mode::scan, ec);
-    
-    if (ec) {
-        http::response<http::string_body> err_res{http::status::internal_server_error, 11};
-        err_res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-        err_res.set(http::field::content_type, "text/plain");
-        err_res.body() = "Failed to open file\r\n";
-        err_res.prepare_payload();
-        add_cors_headers(err_res);
-        return send_response(std::move(err_res));
+
+    if (AssetCache::matches(asset, toStringView(request_[http::field::if_none_match]))) {
+        res.result(http::status::not_modified);
+    } else {
+        if (variant.encoding != AssetCache::Encoding::Identity) {
+            res.set(http::field::content_encoding, AssetCache::encodingName(variant.encoding));
+        }
+        // The span points into the cached buffer; the handler keeps it alive.
+        res.body() = {variant.body->data(), variant.body->size()};
+        res.content_length(variant.body->size());
     }
-    
-    auto const size = body.size();
-    
-    res.body() = std::move(body);
-    res.content_length(size);
-    res.keep_alive(true);
-    
-    auto sp = std::make_shared<http::response<http::file_body>>(std::move(res));
-    http::async_write(socket_, *sp,
-        [self = shared_from_this(), sp](beast::error_code ec, std::size_t) {
-            if (ec) {
-                std::cerr << "Error writing file: " << ec.message() << std::endl;
-            }
-            self->socket_.shutdown(tcp::socket::shutdown_send, ec);
+    res.keep_alive(keep_alive());
+
+    auto sp = std::make_shared<http::response<http::span_body<char const>>>(std::move(res));
+    stream_.expires_after(write_timeout);
+    http::async_write(stream_, *sp,
+        [self = shared_from_this(), sp, body = variant.body](beast::error_code ec, std::size_t bytes) {
+            self->on_write(sp->need_eof(), ec, bytes);
         });
-} 
\ No newline at end of file
+}
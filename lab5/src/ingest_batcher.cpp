@@ -0,0 +1,46 @@
+#include "ingest_batcher.h"
+#include <iostream>
+
+IngestBatcher::IngestBatcher(std::shared_ptr<DbManager> db_manager,
+                             size_t max_batch_size,
+                             std::chrono::milliseconds max_delay)
+    : db_manager_(std::move(db_manager))
+    , max_batch_size_(max_batch_size > 0 ? max_batch_size : 1)
+    , max_delay_(max_delay) {
+    pending_.reserve(max_batch_size_);
+}
+
+IngestBatcher::~IngestBatcher() {
+    try {
+        flush();
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to flush " << pending_.size() << " readings: " << e.what() << std::endl;
+    }
+}
+
+void IngestBatcher::add(int sensor, time_t timestamp, double temperature) {
+    if (pending_.empty()) {
+        oldest_ = std::chrono::steady_clock::now();
+    }
+    pending_.push_back({timestamp, temperature, sensor});
+
+    if (pending_.size() >= max_batch_size_) {
+        flush();
+    }
+}
+
+void IngestBatcher::flushIfDue() {
+    if (!pending_.empty() && std::chrono::steady_clock::now() - oldest_ >= max_delay_) {
+        flush();
+    }
+}
+
+void IngestBatcher::flush() {
+    if (pending_.empty()) {
+        return;
+    }
+
+    // On failure the batch stays pending and is retried by the next flush.
+    db_manager_->insertTemperatures(pending_);
+    pending_.clear();
+}
@@ -0,0 +1,126 @@
+#include "ingest_writer.h"
+#include "ingest_batcher.h"
+#include <algorithm>
+#include <iostream>
+
+IngestWriter::IngestWriter(std::shared_ptr<DbManager> db_manager,
+                           size_t capacity,
+                           size_t max_batch_size,
+                           std::chrono::milliseconds max_delay)
+    : db_manager_(std::move(db_manager))
+    , queue_(capacity)
+    , overflowing_(false)
+    , stopping_(false)
+    , thread_(&IngestWriter::run, this, max_batch_size, max_delay) {
+}
+
+IngestWriter::~IngestWriter() {
+    stop();
+}
+
+bool IngestWriter::add(int sensor, time_t timestamp, double temperature) {
+    if (!queue_.push({timestamp, temperature, sensor})) {
+        if (!overflowing_) {
+            overflowing_ = true;
+            backpressure_.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "Ingest queue full, dropping readings until the database catches up" << std::endl;
+        }
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (overflowing_) {
+        overflowing_ = false;
+        std::cerr << "Ingest queue has room again, " << dropped_.load(std::memory_order_relaxed)
+                  << " readings dropped so far" << std::endl;
+    }
+    queued_.fetch_add(1, std::memory_order_relaxed);
+    size_t depth = queue_.size();
+    if (depth > high_water_.load(std::memory_order_relaxed)) {
+        high_water_.store(depth, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void IngestWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeup_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+IngestWriter::Stats IngestWriter::stats() const {
+    Stats stats;
+    stats.queued = queued_.load(std::memory_order_relaxed);
+    stats.written = written_.load(std::memory_order_relaxed);
+    stats.backpressure = backpressure_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.high_water = high_water_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void IngestWriter::run(size_t max_batch_size, std::chrono::milliseconds max_delay) {
+    IngestBatcher batcher(db_manager_, max_batch_size, max_delay);
+
+    // A batch counts as written once the batcher has nothing pending.
+    auto track = [this, &batcher](size_t before, auto&& write) {
+        write();
+        if (batcher.pending() == 0) {
+            written_.fetch_add(before, std::memory_order_relaxed);
+        }
+    };
+
+    // After a failed commit only the pending batch is retried, with a
+    // growing delay; new readings stay in the ring meanwhile, so the batch
+    // does not grow and a full ring drops and counts them in add().
+    const std::chrono::milliseconds min_retry_delay{100};
+    const std::chrono::milliseconds max_retry_delay{5000};
+    std::chrono::milliseconds retry_delay{0};
+
+    TemperatureRecord record;
+    bool stopping = false;
+    while (!stopping) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stopping = stopping_;
+            if (!stopping && (retry_delay.count() > 0 || queue_.size() == 0)) {
+                wakeup_.wait_for(lock, retry_delay.count() > 0 ? retry_delay : poll_interval,
+                                 [this] { return stopping_; });
+                stopping = stopping_;
+            }
+        }
+        if (stopping) {
+            break;
+        }
+
+        try {
+            if (retry_delay.count() > 0) {
+                track(batcher.pending(), [&] { batcher.flush(); });
+                retry_delay = std::chrono::milliseconds(0);
+            }
+            while (queue_.pop(record)) {
+                track(batcher.pending() + 1, [&] { batcher.add(record.sensor, record.timestamp, record.temperature); });
+            }
+            track(batcher.pending(), [&] { batcher.flushIfDue(); });
+        } catch (const std::exception& e) {
+            // The batch stays in the batcher until a retry commits it.
+            retry_delay = retry_delay.count() > 0 ? std::min(retry_delay * 2, max_retry_delay) : min_retry_delay;
+            std::cerr << "Error: " << e.what() << "; retrying " << batcher.pending() << " readings in "
+                      << retry_delay.count() << " ms" << std::endl;
+        }
+    }
+
+    // The reader has stopped adding; whatever is left goes out in one last batch.
+    try {
+        while (queue_.pop(record)) {
+            track(batcher.pending() + 1, [&] { batcher.add(record.sensor, record.timestamp, record.temperature); });
+        }
+        track(batcher.pending(), [&] { batcher.flush(); });
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+}
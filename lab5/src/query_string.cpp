@@ -0,0 +1,89 @@
+#include "query_string.h"
+
+namespace {
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Calls onByte for every decoded byte of s; stops early if onByte returns false.
+template<typename F>
+bool decode(std::string_view s, F onByte) {
+    for (size_t i = 0; i < s.size(); ++i) {
+        char c = s[i];
+        if (c == '+') {
+            c = ' ';
+        } else if (c == '%' && i + 2 < s.size() && hexValue(s[i + 1]) >= 0 && hexValue(s[i + 2]) >= 0) {
+            c = static_cast<char>(hexValue(s[i + 1]) * 16 + hexValue(s[i + 2]));
+            i += 2;
+        }
+        if (!onByte(c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool decodedEquals(std::string_view encoded, std::string_view expected) {
+    size_t pos = 0;
+    bool same = decode(encoded, [&](char c) {
+        return pos < expected.size() && expected[pos++] == c;
+    });
+    return same && pos == expected.size();
+}
+
+} // namespace
+
+std::pair<std::string_view, QueryString> QueryString::splitTarget(std::string_view target) {
+    target = target.substr(0, target.find('#'));
+    size_t question = target.find('?');
+    if (question == std::string_view::npos) {
+        return {target, QueryString()};
+    }
+    return {target.substr(0, question), QueryString(target.substr(question + 1))};
+}
+
+bool QueryString::has(std::string_view key) const {
+    std::string_view encoded;
+    return find(key, encoded);
+}
+
+bool QueryString::get(std::string_view key, Buffer& buffer, std::string_view& value) const {
+    std::string_view encoded;
+    if (!find(key, encoded)) {
+        return false;
+    }
+
+    size_t length = 0;
+    if (!decode(encoded, [&](char c) {
+            if (length == buffer.size()) {
+                return false;
+            }
+            buffer[length++] = c;
+            return true;
+        })) {
+        return false;
+    }
+    value = std::string_view(buffer.data(), length);
+    return true;
+}
+
+bool QueryString::find(std::string_view key, std::string_view& encoded) const {
+    std::string_view rest = query_;
+    while (!rest.empty()) {
+        size_t amp = rest.find('&');
+        std::string_view pair = rest.substr(0, amp);
+        rest = amp == std::string_view::npos ? std::string_view() : rest.substr(amp + 1);
+
+        size_t eq = pair.find('=');
+        std::string_view name = pair.substr(0, eq);
+        if (decodedEquals(name, key)) {
+            encoded = eq == std::string_view::npos ? std::string_view() : pair.substr(eq + 1);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,105 @@
+#include "response_cache.h"
+#include <cstdio>
+#include <random>
+
+namespace {
+
+// Enough to cover the invalidations made while one large response streams.
+constexpr size_t MAX_CHANGES = 1024;
+
+} // namespace
+
+ResponseCache::ResponseCache(size_t max_entries, size_t max_bytes, size_t max_entry_bytes)
+    : max_entries_(max_entries)
+    , max_bytes_(max_bytes)
+    , max_entry_bytes_(max_entry_bytes)
+    , generation_(0)
+    , inserted_(0)
+    , bytes_(0) {
+    std::random_device random;
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%08x%08x", static_cast<unsigned>(random()), static_cast<unsigned>(random()));
+    instance_ = buffer;
+}
+
+std::shared_ptr<const ResponseCache::Entry> ResponseCache::find(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        return nullptr;
+    }
+    order_.splice(order_.begin(), order_, it->second);
+    return it->second->second;
+}
+
+uint64_t ResponseCache::generation() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return generation_;
+}
+
+void ResponseCache::insert(const std::string& key, Entry entry, uint64_t generation) {
+    if (!entry.body || entry.body->size() > max_entry_bytes_) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (changedSince(entry, generation)) {
+        return;
+    }
+    entry.etag = "\"" + instance_ + "-" + std::to_string(++inserted_) + "\"";
+    auto shared = std::make_shared<const Entry>(std::move(entry));
+
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        bytes_ -= it->second->second->body->size();
+        order_.erase(it->second);
+        index_.erase(it);
+    }
+
+    order_.emplace_front(key, shared);
+    index_[key] = order_.begin();
+    bytes_ += shared->body->size();
+    evict();
+}
+
+void ResponseCache::invalidate(int sensor, const std::string& type, time_t from, time_t to) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    changes_.push_back({++generation_, sensor, type, from, to});
+    if (changes_.size() > MAX_CHANGES) {
+        changes_.pop_front();
+    }
+
+    for (auto it = order_.begin(); it != order_.end();) {
+        const Entry& entry = *it->second;
+        if (entry.sensor == sensor && entry.type == type && entry.start <= to && from <= entry.end) {
+            bytes_ -= entry.body->size();
+            index_.erase(it->first);
+            it = order_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool ResponseCache::changedSince(const Entry& entry, uint64_t generation) const {
+    if (generation == generation_) {
+        return false;
+    }
+    if (changes_.empty() || changes_.front().generation > generation + 1) {
+        return true;
+    }
+    for (auto it = changes_.rbegin(); it != changes_.rend() && it->generation > generation; ++it) {
+        if (it->sensor == entry.sensor && it->type == entry.type && entry.start <= it->to && it->from <= entry.end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ResponseCache::evict() {
+    while (!order_.empty() && (order_.size() > max_entries_ || bytes_ > max_bytes_)) {
+        bytes_ -= order_.back().second->body->size();
+        index_.erase(order_.back().first);
+        order_.pop_back();
+    }
+}
@@ -0,0 +1,163 @@
+#include "sensor_frame.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+uint8_t crc8(const uint8_t* data, size_t size) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+FrameEncoder::FrameEncoder(int sensor, unsigned keyframe_interval)
+    : sensor_(static_cast<uint8_t>(sensor))
+    , keyframe_interval_(std::max(keyframe_interval, 1u))
+    , until_keyframe_(0)
+    , last_(0) {
+}
+
+void FrameEncoder::encode(time_t timestamp, double temperature, std::string& out) {
+    uint8_t frame[MAX_FRAME_SIZE];
+    size_t size = 0;
+    frame[size++] = FRAME_SYNC;
+    frame[size++] = sensor_;
+
+    bool keyframe = until_keyframe_ == 0 || timestamp < last_;
+    if (keyframe) {
+        until_keyframe_ = keyframe_interval_;
+    }
+    --until_keyframe_;
+
+    uint64_t value = keyframe ? static_cast<uint64_t>(timestamp) << 1 | 1
+                              : static_cast<uint64_t>(timestamp - last_) << 1;
+    last_ = timestamp;
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        frame[size++] = value ? (byte | 0x80) : byte;
+    } while (value);
+
+    // Out of range readings saturate; NaN ends up at the top.
+    double centi = std::max(-32768.0, std::min(32767.0, std::round(temperature * 100)));
+    uint16_t fixed = static_cast<uint16_t>(static_cast<int16_t>(centi));
+    frame[size++] = static_cast<uint8_t>(fixed & 0xFF);
+    frame[size++] = static_cast<uint8_t>(fixed >> 8);
+
+    frame[size] = crc8(frame + 1, size - 1);
+    ++size;
+    out.append(reinterpret_cast<const char*>(frame), size);
+}
+
+FrameDecoder::FrameDecoder(size_t capacity)
+    : buffer_(std::max(capacity, MAX_FRAME_SIZE))
+    , head_(0)
+    , tail_(0)
+    , in_gap_(false)
+    , bad_(0)
+    , unsynced_(0) {
+    std::memset(has_last_, 0, sizeof(has_last_));
+}
+
+char* FrameDecoder::writePtr() {
+    return buffer_.data() + tail_ % buffer_.size();
+}
+
+size_t FrameDecoder::writable() const {
+    size_t free = buffer_.size() - buffered();
+    size_t to_end = buffer_.size() - static_cast<size_t>(tail_ % buffer_.size());
+    return std::min(free, to_end);
+}
+
+void FrameDecoder::commit(size_t count) {
+    tail_ += std::min(count, writable());
+}
+
+uint8_t FrameDecoder::at(uint64_t position) const {
+    return static_cast<uint8_t>(buffer_[position % buffer_.size()]);
+}
+
+void FrameDecoder::resync() {
+    if (!in_gap_) {
+        in_gap_ = true;
+        std::memset(has_last_, 0, sizeof(has_last_));
+    }
+}
+
+bool FrameDecoder::nextFrame(SensorFrame& frame) {
+    while (head_ < tail_) {
+        if (at(head_) != FRAME_SYNC) {
+            ++head_;
+            resync();
+            continue;
+        }
+
+        // Copied out so the CRC runs over contiguous bytes.
+        uint8_t bytes[MAX_FRAME_SIZE];
+        size_t size = 0;
+        uint64_t position = head_;
+        auto take = [&](size_t count) {
+            if (tail_ - position < count) {
+                return false;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                bytes[size++] = at(position++);
+            }
+            return true;
+        };
+
+        if (!take(2)) {
+            return false;
+        }
+        uint64_t value = 0;
+        bool overlong = true;
+        for (int shift = 0; shift < 70; shift += 7) {
+            if (!take(1)) {
+                return false;
+            }
+            value |= static_cast<uint64_t>(bytes[size - 1] & 0x7F) << shift;
+            if (!(bytes[size - 1] & 0x80)) {
+                overlong = false;
+                break;
+            }
+        }
+        if (!overlong && !take(3)) {
+            return false;
+        }
+
+        if (overlong || crc8(bytes + 1, size - 2) != bytes[size - 1]) {
+            // Not a frame after all; look for the next sync byte inside it.
+            ++bad_;
+            ++head_;
+            resync();
+            continue;
+        }
+
+        head_ = position;
+        in_gap_ = false;
+
+        uint8_t sensor = bytes[1];
+        time_t timestamp;
+        if (value & 1) {
+            timestamp = static_cast<time_t>(value >> 1);
+        } else if (has_last_[sensor]) {
+            timestamp = last_[sensor] + static_cast<time_t>(value >> 1);
+        } else {
+            ++unsynced_;
+            continue;
+        }
+        last_[sensor] = timestamp;
+        has_last_[sensor] = true;
+
+        uint16_t fixed = static_cast<uint16_t>(bytes[size - 3] | bytes[size - 2] << 8);
+        frame.sensor = sensor;
+        frame.timestamp = timestamp;
+        frame.temperature = static_cast<int16_t>(fixed) / 100.0;
+        return true;
+    }
+    return false;
+}
@@ -1,16 +1,147 @@
 #ifndef _WIN32
 
 #include "serial_port.h"
+#include "line_framer.h"
 #include <fcntl.h>
+#include <poll.h>
 #include <termios.h>
 #include <unistd.h>
+#include <cerrno>
 #include <cstring>
 #include <stdexcept>
 
+namespace {
+
+// Waits until a descriptor in fds is readable or has failed. A descriptor
+// that only reports a hangup (a pty whose writer went away) would wake
+// poll() at once on every call, so it is left out of a second wait for the
+// rest of the timeout. Returns false if poll() failed.
+bool waitReadable(std::vector<struct pollfd>& fds, int timeout_ms) {
+    int ready = ::poll(fds.data(), fds.size(), timeout_ms);
+    if (ready <= 0) {
+        return ready == 0 || errno == EINTR;
+    }
+
+    bool hangup_only = true;
+    for (auto& pfd : fds) {
+        if (pfd.revents & (POLLIN | POLLERR | POLLNVAL)) {
+            hangup_only = false;
+        }
+    }
+    if (!hangup_only) {
+        return true;
+    }
+
+    for (auto& pfd : fds) {
+        if (pfd.revents & POLLHUP) {
+            pfd.fd = -1;
+        }
+        pfd.revents = 0;
+    }
+    ready = ::poll(fds.data(), fds.size(), timeout_ms);
+    return ready >= 0 || errno == EINTR;
+}
+
+// A write that finds no room for this long fails.
+constexpr int WRITE_TIMEOUT_MS = 1000;
+
+// Writes all of data to a non-blocking descriptor, which may take only part
+// of it, or nothing (EAGAIN) while the driver's buffer is full; in between
+// it waits in poll() for room. Returns false on an error or if no room
+// appears within WRITE_TIMEOUT_MS.
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n > 0) {
+            data += n;
+            size -= static_cast<size_t>(n);
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            int ready = ::poll(&pfd, 1, WRITE_TIMEOUT_MS);
+            if (ready == 0 || (ready < 0 && errno != EINTR) || (pfd.revents & (POLLERR | POLLNVAL))) {
+                return false;
+            }
+        } else if (n == 0 || errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool baudConstant(int baudRate, speed_t& speed) {
+    switch (baudRate) {
+        case 9600: speed = B9600; return true;
+        case 19200: speed = B19200; return true;
+        case 38400: speed = B38400; return true;
+        case 57600: speed = B57600; return true;
+        case 115200: speed = B115200; return true;
+        // Not every platform defines the rates above 115200.
+#ifdef B230400
+        case 230400: speed = B230400; return true;
+#endif
+#ifdef B460800
+        case 460800: speed = B460800; return true;
+#endif
+#ifdef B500000
+        case 500000: speed = B500000; return true;
+#endif
+#ifdef B576000
+        case 576000: speed = B576000; return true;
+#endif
+#ifdef B921600
+        case 921600: speed = B921600; return true;
+#endif
+        default: return false;
+    }
+}
+
+} // namespace
+
 class SerialPortUnix : public SerialPort {
 private:
     int fd_;
     bool is_open_;
+    LineFramer framer_;
+    FrameDecoder decoder_;
+    std::string line_;
+
+    // Lines and frames are read through their own ring.
+    LineFramer& framerFor(std::vector<std::string>&) { return framer_; }
+    FrameDecoder& framerFor(std::vector<SensorFrame>&) { return decoder_; }
+
+    // Reads until the driver has nothing left, taking records out whenever
+    // the ring fills so a burst larger than the ring is not lost.
+    template <typename Record>
+    bool drain(std::vector<Record>& records) {
+        auto& ring = framerFor(records);
+        for (;;) {
+            if (ring.writable() == 0) {
+                take(records);
+            }
+
+            ssize_t n = ::read(fd_, ring.writePtr(), ring.writable());
+            if (n > 0) {
+                ring.commit(static_cast<size_t>(n));
+            } else if (n == 0 || errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            } else if (errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    void take(std::vector<std::string>& lines) {
+        while (framer_.nextLine(line_)) {
+            lines.push_back(line_);
+        }
+    }
+
+    void take(std::vector<SensorFrame>& frames) {
+        SensorFrame frame;
+        while (decoder_.nextFrame(frame)) {
+            frames.push_back(frame);
+        }
+    }
 
 public:
     SerialPortUnix() : fd_(-1), is_open_(false) {}
@@ -22,24 +153,19 @@ public:
     }
 
     bool open(const std::string& port, int baudRate) override {
-        fd_ = ::open(port.c_str(), O_RDWR | O_NOCTTY | O_NDELAY);
+        speed_t baud;
+        if (!baudConstant(baudRate, baud)) {
+            return false;
+        }
+
+        fd_ = ::open(port.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
         if (fd_ == -1) {
             return false;
         }
 
         struct termios options;
         tcgetattr(fd_, &options);
-        
-        speed_t baud;
-        switch (baudRate) {
-            case 9600: baud = B9600; break;
-            case 19200: baud = B19200; break;
-            case 38400: baud = B38400; break;
-            case 57600: baud = B57600; break;
-            case 115200: baud = B115200; break;
-            default: baud = B9600; break;
-        }
-        
+
         cfsetispeed(&options, baud);
         cfsetospeed(&options, baud);
 
@@ -55,9 +181,14 @@ public:
         options.c_oflag &= ~OPOST;
         
         options.c_iflag &= ~(IXON | IXOFF | IXANY);
+        // Binary frames must arrive byte for byte: no CR/NL mapping,
+        // stripping or break handling.
+        options.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL);
         
         tcsetattr(fd_, TCSANOW, &options);
         
+        framer_ = LineFramer();
+        decoder_ = FrameDecoder();
         is_open_ = true;
         return true;
     }
@@ -72,7 +203,7 @@ public:
 
     bool write(const std::string& data) override {
         if (!is_open_) return false;
-        return ::write(fd_, data.c_str(), data.length()) > 0;
+        return writeAll(fd_, data.data(), data.size());
     }
 
     bool read(std::string& data) override {
@@ -90,6 +221,39 @@ public:
         return false;
     }
 
+    bool readLines(std::vector<std::string>& lines, int timeout_ms) override {
+        if (!is_open_) return false;
+
+        std::vector<struct pollfd> fds = {{fd_, POLLIN, 0}};
+        return waitReadable(fds, timeout_ms) && readReady(fds[0].revents, lines);
+    }
+
+    bool readFrames(std::vector<SensorFrame>& frames, int timeout_ms) override {
+        if (!is_open_) return false;
+
+        std::vector<struct pollfd> fds = {{fd_, POLLIN, 0}};
+        return waitReadable(fds, timeout_ms) && readReady(fds[0].revents, frames);
+    }
+
+    int handle() const {
+        return fd_;
+    }
+
+    // Handles what poll() reported for this port.
+    template <typename Record>
+    bool readReady(short revents, std::vector<Record>& records) {
+        if (revents & (POLLERR | POLLNVAL)) {
+            return false;
+        }
+        if (!(revents & POLLIN)) {
+            return true;
+        }
+
+        bool ok = drain(records);
+        take(records);
+        return ok;
+    }
+
     bool isOpen() const override {
         return is_open_;
     }
@@ -99,4 +263,49 @@ std::unique_ptr<SerialPort> SerialPort::create() {
     return std::make_unique<SerialPortUnix>();
 }
 
-#endif 
\ No newline at end of file
+namespace {
+
+// One poll() over every port, so a reading on any of them is handled as
+// soon as it arrives, however many ports there are. records(i) is where
+// the records of ports[i] go.
+template <typename Records>
+bool readPorts(const std::vector<std::unique_ptr<SerialPort>>& ports, int timeout_ms, Records records) {
+    std::vector<struct pollfd> fds(ports.size());
+    bool any_open = false;
+    for (size_t i = 0; i < ports.size(); ++i) {
+        auto* port = static_cast<SerialPortUnix*>(ports[i].get());
+        // poll() ignores negative descriptors.
+        fds[i] = {port->isOpen() ? port->handle() : -1, POLLIN, 0};
+        any_open = any_open || port->isOpen();
+    }
+    if (!any_open) {
+        return false;
+    }
+
+    if (!waitReadable(fds, timeout_ms)) {
+        return false;
+    }
+
+    for (size_t i = 0; i < ports.size(); ++i) {
+        auto* port = static_cast<SerialPortUnix*>(ports[i].get());
+        if (fds[i].revents && !port->readReady(fds[i].revents, records(i))) {
+            port->close();
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool SerialPort::readLines(const std::vector<std::unique_ptr<SerialPort>>& ports,
+                           std::vector<std::vector<std::string>>& lines, int timeout_ms) {
+    lines.resize(ports.size());
+    return readPorts(ports, timeout_ms, [&](size_t i) -> std::vector<std::string>& { return lines[i]; });
+}
+
+bool SerialPort::readFrames(const std::vector<std::unique_ptr<SerialPort>>& ports,
+                            std::vector<SensorFrame>& frames, int timeout_ms) {
+    return readPorts(ports, timeout_ms, [&](size_t) -> std::vector<SensorFrame>& { return frames; });
+}
+
+#endif
@@ -0,0 +1,62 @@
+#include "sqlite_statement.h"
+#include <stdexcept>
+#include <utility>
+
+SqliteStatement::SqliteStatement() : stmt_(nullptr) {}
+
+SqliteStatement::SqliteStatement(sqlite3* db, const char* sql) : stmt_(nullptr) {
+    int rc = sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt_, nullptr);
+    if (rc != SQLITE_OK) {
+        throw std::runtime_error("Failed to prepare statement: " + std::string(sqlite3_errmsg(db)));
+    }
+}
+
+SqliteStatement::~SqliteStatement() {
+    sqlite3_finalize(stmt_);
+}
+
+SqliteStatement::SqliteStatement(SqliteStatement&& other) noexcept
+    : stmt_(std::exchange(other.stmt_, nullptr)) {}
+
+SqliteStatement& SqliteStatement::operator=(SqliteStatement&& other) noexcept {
+    if (this != &other) {
+        sqlite3_finalize(stmt_);
+        stmt_ = std::exchange(other.stmt_, nullptr);
+    }
+    return *this;
+}
+
+void SqliteStatement::bind(int index, sqlite3_int64 value) {
+    sqlite3_bind_int64(stmt_, index, value);
+}
+
+void SqliteStatement::bind(int index, double value) {
+    sqlite3_bind_double(stmt_, index, value);
+}
+
+void SqliteStatement::bind(int index, const std::string& value) {
+    sqlite3_bind_text(stmt_, index, value.c_str(), static_cast<int>(value.size()), SQLITE_STATIC);
+}
+
+bool SqliteStatement::step() {
+    int rc = sqlite3_step(stmt_);
+    if (rc == SQLITE_ROW) {
+        return true;
+    }
+    if (rc != SQLITE_DONE) {
+        throw std::runtime_error("SQL error: " + std::string(sqlite3_errmsg(sqlite3_db_handle(stmt_))));
+    }
+    return false;
+}
+
+void SqliteStatement::exec() {
+    StatementScope scope(*this);
+    step();
+}
+
+void SqliteStatement::reset() {
+    if (stmt_) {
+        sqlite3_reset(stmt_);
+        sqlite3_clear_bindings(stmt_);
+    }
+}
@@ -0,0 +1,18 @@
+#include "storage_profile.h"
+
+bool parseDurability(const std::string& name, Durability& durability) {
+    if (name == "full") durability = Durability::Full;
+    else if (name == "normal") durability = Durability::Normal;
+    else if (name == "off") durability = Durability::Off;
+    else return false;
+    return true;
+}
+
+const char* durabilityName(Durability durability) {
+    switch (durability) {
+        case Durability::Full: return "full";
+        case Durability::Normal: return "normal";
+        case Durability::Off: return "off";
+    }
+    return "normal";
+}
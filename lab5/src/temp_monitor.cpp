@@ -1,13 +1,18 @@
 #include "serial_port.h"
 #include "http_server.h"
 #include "db_manager.h"
+#include "event_broadcaster.h"
+#include "ingest_writer.h"
+#include "reading_parser.h"
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <memory>
 #include <csignal>
 #include <filesystem>
-#include <sstream>
+#include <vector>
 
 #ifdef __APPLE__
 #include <mach-o/dyld.h>
@@ -40,19 +45,82 @@ fs::path get_executable_path() {
     return fs::current_path();
 }
 
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--durability full|normal|off] [--threads N] [--baud N] [--protocol text|binary] <serial_port>..." << std::endl;
+    std::cerr << "  With text lines each port is one sensor, numbered from 0 in the order given;" << std::endl;
+    std::cerr << "  binary frames carry their own sensor id" << std::endl;
+    std::cerr << "  --durability    SQLite synchronous level (default: normal)" << std::endl;
+    std::cerr << "  --threads       HTTP worker threads (default: one per CPU core)" << std::endl;
+    std::cerr << "  --baud          serial line speed, 9600 to 921600 (default: 9600)" << std::endl;
+    std::cerr << "  --protocol      what the sensors send (default: text)" << std::endl;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <serial_port>" << std::endl;
+    StorageProfile storage;
+    size_t http_threads = 0;
+    int baud_rate = 9600;
+    bool binary = false;
+    std::vector<std::string> port_names;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--durability" && i + 1 < argc) {
+            if (!parseDurability(argv[++i], storage.durability)) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--threads" && i + 1 < argc) {
+            http_threads = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--baud" && i + 1 < argc) {
+            baud_rate = std::atoi(argv[++i]);
+        } else if (arg == "--protocol" && i + 1 < argc) {
+            std::string protocol = argv[++i];
+            if (protocol != "text" && protocol != "binary") {
+                print_usage(argv[0]);
+                return 1;
+            }
+            binary = protocol == "binary";
+        } else if (!arg.empty() && arg[0] == '-') {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            port_names.push_back(arg);
+        }
+    }
+
+    if (port_names.empty() || port_names.size() > MAX_SENSORS) {
+        print_usage(argv[0]);
         return 1;
     }
 
+    if (http_threads == 0) {
+        http_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // Every HTTP worker may be running a history query at the same time.
+    storage.read_connections = std::max(storage.read_connections, http_threads);
+
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
 
     try {
-        auto dbManager = std::make_shared<DbManager>("temperature.db");
+        auto dbManager = std::make_shared<DbManager>("temperature.db", storage);
         dbManager->createTables();
 
+        auto warm_start_begin = std::chrono::steady_clock::now();
+        dbManager->warmStart();
+        auto warm_start_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - warm_start_begin).count();
+
+        auto warm = dbManager->warmState();
+        std::cout << "Warm start in " << warm_start_ms << " ms, " << warm.size() << " sensors" << std::endl;
+        for (const auto& [sensor, state] : warm) {
+            if (state.has_latest) {
+                std::cout << "  sensor " << sensor << ": last reading "
+                          << state.latest.temperature << "°C at " << state.latest.timestamp
+                          << ", open hour has " << state.hour.count << " readings" << std::endl;
+            }
+        }
+
         fs::path exe_path = get_executable_path();
         std::string doc_root = (exe_path / "public").string();
         
@@ -62,7 +130,10 @@ int main(int argc, char* argv[]) {
             fs::create_directory(doc_root);
         }
 
-        server = std::make_unique<HttpServer>("0.0.0.0", 8080, doc_root, dbManager);
+        auto events = std::make_shared<EventBroadcaster>();
+        dbManager->addIngestEvents(ApiHandler::streamEvents(events));
+
+        server = std::make_unique<HttpServer>("0.0.0.0", 8080, doc_root, dbManager, events, http_threads);
         
         std::thread server_thread([server_ptr = server.get()]() {
             try {
@@ -74,28 +145,65 @@ int main(int argc, char* argv[]) {
             }
         });
 
-        auto port = SerialPort::create();
-        if (!port->open(argv[1], 9600)) {
-            std::cerr << "Failed to open serial port" << std::endl;
-            running = false;
+        // With text lines the index of a port is the id of its sensor.
+        std::vector<std::unique_ptr<SerialPort>> ports;
+        for (const auto& port_name : port_names) {
+            ports.push_back(SerialPort::create());
+            if (!ports.back()->open(port_name, baud_rate)) {
+                std::cerr << "Failed to open serial port " << port_name << " at " << baud_rate << " baud" << std::endl;
+                running = false;
+            }
         }
+        std::vector<bool> port_open(ports.size(), true);
 
         std::cout << "Server started at http://localhost:8080" << std::endl;
         std::cout << "Press Ctrl+C to stop" << std::endl;
 
+        // This thread only reads the ports; commits happen on the writer's
+        // thread. The ring holds about 18 minutes of 60 sensors at 1 Hz.
+        IngestWriter writer(dbManager, 65536, 256, std::chrono::milliseconds(1000));
+
+        // All ports are waited on together. The timeout only bounds how
+        // quickly Ctrl+C is noticed; readings are handled as they arrive.
+        std::vector<std::vector<std::string>> lines(ports.size());
+        std::vector<SensorFrame> frames;
         while (running) {
             try {
-                std::string data;
-                if (port->read(data)) {
-                    std::istringstream iss(data);
-                    time_t timestamp;
-                    double temperature;
-                    if (iss >> timestamp >> temperature) {
-                        dbManager->insertTemperature(timestamp, temperature, "raw");
-                        std::cout << "Temperature: " << temperature << "°C" << std::endl;
+                for (auto& port_lines : lines) {
+                    port_lines.clear();
+                }
+                frames.clear();
+                bool ok = binary ? SerialPort::readFrames(ports, frames, 100)
+                                 : SerialPort::readLines(ports, lines, 100);
+                if (!ok) {
+                    std::cerr << "No serial port left to read from" << std::endl;
+                    break;
+                }
+
+                for (const auto& frame : frames) {
+                    writer.add(frame.sensor, frame.timestamp, frame.temperature);
+                    std::cout << "Sensor " << frame.sensor << ": " << frame.temperature << "°C" << std::endl;
+                }
+
+                for (size_t port = 0; port < ports.size(); ++port) {
+                    for (const auto& line : lines[port]) {
+                        time_t timestamp;
+                        double temperature;
+                        ParseStatus status = parseReading(line, timestamp, temperature);
+                        if (status == ParseStatus::Ok) {
+                            writer.add(static_cast<int>(port), timestamp, temperature);
+                            std::cout << "Sensor " << port << ": " << temperature << "°C" << std::endl;
+                        } else if (status != ParseStatus::Empty) {
+                            std::cerr << "Sensor " << port << ": skipped malformed reading ("
+                                      << parseStatusName(status) << "): " << line << std::endl;
+                        }
+                    }
+                    if (port_open[port] && !ports[port]->isOpen()) {
+                        std::cerr << "Lost serial port " << port_names[port]
+                                  << (binary ? "" : " (sensor " + std::to_string(port) + ")") << std::endl;
+                        port_open[port] = false;
                     }
                 }
-                std::this_thread::sleep_for(std::chrono::seconds(1));
             } catch (const std::exception& e) {
                 std::cerr << "Error: " << e.what() << std::endl;
                 std::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -103,6 +211,12 @@ int main(int argc, char* argv[]) {
         }
 
         std::cout << "\nShutting down..." << std::endl;
+
+        writer.stop();
+        IngestWriter::Stats stats = writer.stats();
+        std::cout << "Ingest: " << stats.queued << " readings queued, " << stats.written << " written, "
+                  << stats.dropped << " dropped, ring full " << stats.backpressure
+                  << " times, at most " << stats.high_water << " waiting" << std::endl;
         
         if (server) {
             server->stop();
@@ -112,7 +226,9 @@ int main(int argc, char* argv[]) {
             server_thread.join();
         }
         
-        port->close();
+        for (auto& port : ports) {
+            port->close();
+        }
 
     } catch (const std::exception& e) {
         std::cerr << "Fatal error: " << e.what() << std::endl;
@@ -4,21 +4,49 @@
 #include <random>
 #include <ctime>
 #include <sstream>
+#include <cstdlib>
 #include "serial_port.h"
+#include "sensor_frame.h"
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cout << "Usage: " << argv[0] << " <port>" << std::endl;
+    std::string portName;
+    int baudRate = 9600;
+    bool binary = false;
+    int sensor = 0;
+
+    bool usage = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--baud" && i + 1 < argc) {
+            baudRate = std::atoi(argv[++i]);
+        } else if (arg == "--protocol" && i + 1 < argc) {
+            std::string protocol = argv[++i];
+            binary = protocol == "binary";
+            usage = usage || (!binary && protocol != "text");
+        } else if (arg == "--sensor" && i + 1 < argc) {
+            sensor = std::atoi(argv[++i]);
+            usage = usage || sensor < 0 || sensor > 255;
+        } else if (portName.empty() && !arg.empty() && arg[0] != '-') {
+            portName = arg;
+        } else {
+            usage = true;
+        }
+    }
+
+    if (usage || portName.empty()) {
+        std::cout << "Usage: " << argv[0] << " [--baud N] [--protocol text|binary] [--sensor N] <port>" << std::endl;
         std::cout << "Example: " << argv[0] << " COM1    (on Windows)" << std::endl;
         std::cout << "Example: " << argv[0] << " /dev/ttyUSB0    (on Unix)" << std::endl;
+        std::cout << "  --baud N        line speed, 9600 to 921600 (default 9600)" << std::endl;
+        std::cout << "  --protocol      text lines or binary frames (default text)" << std::endl;
+        std::cout << "  --sensor N      sensor id sent in binary frames, 0 to 255 (default 0)" << std::endl;
         return 1;
     }
 
-    std::string portName = argv[1];
     auto serialPort = SerialPort::create();
 
-    if (!serialPort->open(portName, 9600)) {
-        std::cerr << "Failed to open serial port: " << portName << std::endl;
+    if (!serialPort->open(portName, baudRate)) {
+        std::cerr << "Failed to open serial port: " << portName << " at " << baudRate << " baud" << std::endl;
         return 1;
     }
 
@@ -27,6 +55,7 @@ int main(int argc, char* argv[]) {
     std::random_device rd;
     std::mt19937 gen(rd());
     std::normal_distribution<> temp_dist(20.0, 10.0);
+    FrameEncoder encoder(sensor);
 
     while (true) {
         try {
@@ -35,10 +64,16 @@ int main(int argc, char* argv[]) {
             auto now = std::chrono::system_clock::now();
             auto timestamp = std::chrono::system_clock::to_time_t(now);
             
-            std::ostringstream oss;
-            oss << timestamp << " " << temperature << "\n";
+            std::string data;
+            if (binary) {
+                encoder.encode(timestamp, temperature, data);
+            } else {
+                std::ostringstream oss;
+                oss << timestamp << " " << temperature << "\n";
+                data = oss.str();
+            }
             
-            if (!serialPort->write(oss.str())) {
+            if (!serialPort->write(data)) {
                 std::cerr << "Failed to write to serial port" << std::endl;
                 break;
             }
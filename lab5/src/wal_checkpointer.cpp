@@ -0,0 +1,49 @@
+#include "wal_checkpointer.h"
+#include <sqlite3.h>
+#include <iostream>
+
+WalCheckpointer::WalCheckpointer(const std::string& db_path, std::chrono::seconds interval, int busy_timeout_ms)
+    : db_path_(db_path)
+    , interval_(interval)
+    , busy_timeout_ms_(busy_timeout_ms)
+    , stopping_(false)
+    , thread_(&WalCheckpointer::run, this) {
+}
+
+WalCheckpointer::~WalCheckpointer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeup_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void WalCheckpointer::run() {
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(db_path_.c_str(), &db, SQLITE_OPEN_READWRITE, nullptr) != SQLITE_OK) {
+        std::cerr << "Checkpointer can't open database: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        return;
+    }
+    sqlite3_busy_timeout(db, busy_timeout_ms_);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!wakeup_.wait_for(lock, interval_, [this] { return stopping_; })) {
+        lock.unlock();
+
+        int wal_frames = 0;
+        int checkpointed = 0;
+        int rc = sqlite3_wal_checkpoint_v2(db, nullptr, SQLITE_CHECKPOINT_PASSIVE, &wal_frames, &checkpointed);
+        if (rc != SQLITE_OK && rc != SQLITE_BUSY) {
+            std::cerr << "WAL checkpoint failed: " << sqlite3_errmsg(db) << std::endl;
+        }
+
+        lock.lock();
+    }
+    lock.unlock();
+
+    sqlite3_close(db);
+}
@@ -0,0 +1,73 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include "asset_cache.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+AssetCache::Asset makeAsset(bool gzip, bool brotli) {
+    AssetCache::Asset asset;
+    asset.content_type = "text/html";
+    asset.etag = "abc";
+    asset.identity = std::make_shared<const std::string>(300, 'x');
+    if (gzip) {
+        asset.gzip = std::make_shared<const std::string>(200, 'g');
+    }
+    if (brotli) {
+        asset.brotli = std::make_shared<const std::string>(100, 'b');
+    }
+    return asset;
+}
+
+void expect(const AssetCache::Asset& asset, const char* accept_encoding, AssetCache::Encoding expected) {
+    AssetCache::Encoding got = AssetCache::select(asset, accept_encoding).encoding;
+    check(got == expected, std::string("Accept-Encoding \"") + accept_encoding + "\" selects " +
+                               AssetCache::encodingName(got) + ", expected " + AssetCache::encodingName(expected));
+}
+
+void test_select() {
+    std::cout << "Test: Accept-Encoding selection" << std::endl;
+    using Encoding = AssetCache::Encoding;
+    auto gzip_only = makeAsset(true, false);
+    auto brotli_only = makeAsset(false, true);
+    auto both = makeAsset(true, true);
+
+    expect(both, "", Encoding::Identity);
+    expect(both, "gzip", Encoding::Gzip);
+    expect(both, "gzip, br", Encoding::Brotli);
+    expect(both, "*", Encoding::Brotli);
+    expect(both, "br;q=0, gzip", Encoding::Gzip);
+
+    // An explicit refusal is not overridden by a later wildcard.
+    expect(gzip_only, "gzip;q=0, *", Encoding::Identity);
+    expect(gzip_only, "*, gzip;q=0", Encoding::Identity);
+    expect(brotli_only, "br;q=0, *", Encoding::Identity);
+    expect(both, "br;q=0, *", Encoding::Gzip);
+    expect(both, "gzip;q=0, *", Encoding::Brotli);
+
+    // A refused wildcard does not take back what is named.
+    expect(gzip_only, "gzip, *;q=0", Encoding::Gzip);
+    expect(both, "*;q=0", Encoding::Identity);
+}
+
+} // namespace
+
+int main() {
+    test_select();
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All tests passed" << std::endl;
+    return 0;
+}